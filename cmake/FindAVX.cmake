@@ -8,6 +8,7 @@ if(CMAKE_SYSTEM_NAME MATCHES "Linux")
   string(FIND "${CPUINFO}" "avx" AVX_FOUND)
   string(FIND "${CPUINFO}" "avx2" AVX2_FOUND)
   string(FIND "${CPUINFO}" "avx512" AVX512_FOUND)
+  string(FIND "${CPUINFO}" "f16c" F16C_FOUND)
 
   if(SSE_FOUND GREATER -1)
     set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -msse")
@@ -29,6 +30,11 @@ if(CMAKE_SYSTEM_NAME MATCHES "Linux")
     message(STATUS "Building with AVX2")
   endif()
 
+  if(F16C_FOUND GREATER -1)
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -mf16c")
+    message(STATUS "Building with F16C")
+  endif()
+
   if(AVX512_FOUND GREATER -1)
     set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -mavx512f -mavx512dq -mavx512vl -mavx512bw -mavx512vnni")
     message(STATUS "Building with AVX512")
@@ -184,7 +184,9 @@ def train_index(
     """
     Creates and trains an index on the given dataset.
     :param train_dataset: The dataset to train the index on.
-    :param distance_type: The distance type to use. Options include "l2" and "angular".
+    :param distance_type: The distance type to use. Options include "l2", "ip" and "angular".
+        As in the benchmark configurations, "angular" is the inner product distance, for
+        both flatnav and hnswlib.
     :param dim: The dimensionality of the dataset.
     :param dataset_size: The number of points in the dataset.
     :param max_edges_per_node: The maximum number of edges per node in the graph.
@@ -195,9 +197,12 @@ def train_index(
     :param num_build_threads: The number of threads to use during index construction.
     :return: The trained index.
     """
+    # The benchmarks use "angular" for the inner product ("ip"), with inner product
+    # ground truth. flatnav's "angular" is the cosine distance, so both libraries are
+    # given "ip".
+    _distance_type = distance_type if distance_type == "l2" else "ip"
+
     if index_type == "hnsw":
-        # We use "angular" instead of "ip", so here we are just converting.
-        _distance_type = distance_type if distance_type == "l2" else "ip"
         # HNSWlib will have M * 2 edges in the base layer.
         # So if we want to use M=32, we need to set M=16 here.
         hnsw_index = create_and_train_hnsw_index(
@@ -216,7 +221,6 @@ def train_index(
         if not hnsw_base_layer_filename:
             raise ValueError("Must provide a filename for the HNSW base layer graph.")
 
-        _distance_type = distance_type if distance_type == "l2" else "ip"
         create_and_train_hnsw_index(
             data=train_dataset,
             space=_distance_type,
@@ -232,7 +236,7 @@ def train_index(
             raise ValueError(f"Failed to create {hnsw_base_layer_filename=}")
 
         index = flatnav.index.create(
-            distance_type=distance_type,
+            distance_type=_distance_type,
             index_data_type=FLATNAV_DATA_TYPES[data_type],
             index_entry_policy=FLATNAV_ENTRY_POLICIES[entry_policy],
             dim=dim,
@@ -252,7 +256,7 @@ def train_index(
 
     else:
         index = flatnav.index.create(
-            distance_type=distance_type,
+            distance_type=_distance_type,
             index_data_type=FLATNAV_DATA_TYPES[data_type],
             index_entry_policy=FLATNAV_ENTRY_POLICIES[entry_policy],
             dim=dim,
@@ -456,7 +460,7 @@ def parse_arguments() -> argparse.Namespace:
         "--metric",
         required=True,
         default="l2",
-        help="Distance tye. Options include `l2` and `angular`.",
+        help="Distance type. Options include `l2`, `ip` and `angular`, which is the inner product.",
     )
 
     parser.add_argument(
@@ -0,0 +1,290 @@
+#pragma once
+
+#include <flatnav/index/Index.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace flatnav::build {
+
+// Parameters of the NN-Descent kNN graph builder.
+struct NNDescentParameters {
+  // Number of neighbors kept per node. 0 selects M.
+  size_t k = 0;
+  // Fraction of the new neighbors of a node (and of its reverse neighbors)
+  // joined in each iteration. Lower values trade convergence speed for fewer
+  // distance computations.
+  float sample_rate = 0.5f;
+  // Stop once an iteration improves fewer than delta * num_nodes * k entries.
+  float delta = 0.001f;
+  size_t max_iterations = 10;
+  uint64_t seed = 100;
+  // Passed to `Index::importKnnGraph` once the kNN graph has converged.
+  bool prune = true;
+  bool add_reverse_edges = true;
+};
+
+/**
+ * @brief Builds the links of an index with allocated but unlinked nodes (see
+ * `Index::allocateNode`) from an approximate kNN graph computed with
+ * NN-Descent (Dong et al., "Efficient K-Nearest Neighbor Graph Construction
+ * for Generic Similarity Measures", WWW 2011).
+ *
+ * Every iteration joins, for each node, its sampled new neighbors with each
+ * other and with its old neighbors, on the assumption that a neighbor of a
+ * neighbor is likely a neighbor. The joins only read the neighbor lists and
+ * emit candidate updates. The updates are then grouped by target node and
+ * applied in parallel, so that every list is modified by exactly one thread
+ * and no locks are taken.
+ */
+template <typename dist_t, typename label_t, typename node_id_t>
+class NNDescent {
+  using index_t = Index<dist_t, label_t, node_id_t>;
+  // (target, (distance, source))
+  using Update = std::pair<node_id_t, std::pair<float, node_id_t>>;
+
+  struct Neighbor {
+    float distance;
+    node_id_t id;
+    bool is_new;
+  };
+
+  // Number of nodes joined before their updates are applied. This bounds the
+  // memory used to buffer updates.
+  static constexpr size_t NODES_PER_CHUNK = 1 << 16;
+
+ public:
+  NNDescent(index_t& index, const NNDescentParameters& parameters)
+      : _index(index),
+        _parameters(parameters),
+        _num_nodes(index._cur_num_nodes),
+        _k(std::min(parameters.k ? parameters.k : index._M, _num_nodes ? _num_nodes - 1 : 0)),
+        _sample_size(std::max<size_t>(static_cast<size_t>(parameters.sample_rate * _k), 1)) {
+    if (parameters.sample_rate <= 0 || parameters.sample_rate > 1) {
+      throw std::invalid_argument("NN-Descent sample rate must be in (0, 1].");
+    }
+  }
+
+  void build() {
+    if (_k == 0) {
+      return;
+    }
+    initializeNeighbors();
+    for (size_t iteration = 0; iteration < _parameters.max_iterations; iteration++) {
+      sampleCandidates();
+      size_t num_updates = localJoin();
+      if (num_updates < _parameters.delta * _num_nodes * _k) {
+        break;
+      }
+    }
+
+    std::vector<node_id_t> knn_graph(_num_nodes * _k);
+    for (size_t i = 0; i < knn_graph.size(); i++) {
+      knn_graph[i] = _neighbors[i].id;
+    }
+    _neighbors.clear();
+    _neighbors.shrink_to_fit();
+    // Unfilled entries point to the node itself and are skipped.
+    _index.importKnnGraph(knn_graph.data(), _num_nodes, _k, _parameters.prune, _parameters.add_reverse_edges);
+  }
+
+ private:
+  float distance(node_id_t a, node_id_t b) const {
+    return _index._distance->distance(/* x = */ _index.getNodeData(a), /* y = */ _index.getNodeData(b));
+  }
+
+  /**
+   * @brief Inserts `id` into the sorted neighbor list of `node` if it is
+   * closer than the furthest neighbor and not already there.
+   * @return true if the list changed.
+   */
+  bool insertNeighbor(node_id_t node, float distance, node_id_t id) {
+    Neighbor* neighbors = _neighbors.data() + node * _k;
+    if (id == node || distance >= neighbors[_k - 1].distance) {
+      return false;
+    }
+    for (size_t i = 0; i < _k; i++) {
+      if (neighbors[i].id == id) {
+        return false;
+      }
+    }
+    size_t position = _k - 1;
+    while (position > 0 && neighbors[position - 1].distance > distance) {
+      neighbors[position] = neighbors[position - 1];
+      position--;
+    }
+    neighbors[position] = {distance, id, true};
+    return true;
+  }
+
+  // Starts every node with k distinct random neighbors.
+  void initializeNeighbors() {
+    _neighbors.assign(_num_nodes * _k, Neighbor());
+    _index.parallelFor(0, _num_nodes, [&](uint64_t node) {
+      Neighbor* neighbors = _neighbors.data() + node * _k;
+      for (size_t i = 0; i < _k; i++) {
+        neighbors[i] = {std::numeric_limits<float>::max(), static_cast<node_id_t>(node), false};
+      }
+      std::mt19937_64 generator(_parameters.seed + node);
+      std::uniform_int_distribution<uint64_t> distribution(0, _num_nodes - 1);
+      for (size_t attempt = 0; attempt < 2 * _k && neighbors[_k - 1].id == node; attempt++) {
+        node_id_t candidate = distribution(generator);
+        insertNeighbor(node, distance(node, candidate), candidate);
+      }
+    });
+  }
+
+  /**
+   * @brief Samples up to `_sample_size` new and old neighbors of every node
+   * and adds as many of its reverse neighbors to each list. Sampled new
+   * neighbors are marked old.
+   */
+  void sampleCandidates() {
+    _new_candidates.assign(_num_nodes, {});
+    _old_candidates.assign(_num_nodes, {});
+    _index.parallelFor(0, _num_nodes, [&](uint64_t node) {
+      Neighbor* neighbors = _neighbors.data() + node * _k;
+      for (size_t i = 0; i < _k && neighbors[i].id != node; i++) {
+        if (neighbors[i].is_new) {
+          if (_new_candidates[node].size() < _sample_size) {
+            _new_candidates[node].push_back(neighbors[i].id);
+            neighbors[i].is_new = false;
+          }
+        } else if (_old_candidates[node].size() < _sample_size) {
+          _old_candidates[node].push_back(neighbors[i].id);
+        }
+      }
+    });
+    addReverseCandidates(_new_candidates);
+    addReverseCandidates(_old_candidates);
+  }
+
+  void addReverseCandidates(std::vector<std::vector<node_id_t>>& candidates) {
+    // (target, source) pairs, sorted so that the sources of a target are
+    // contiguous.
+    std::vector<std::pair<node_id_t, node_id_t>> reverse_edges;
+    for (size_t node = 0; node < _num_nodes; node++) {
+      for (node_id_t neighbor : candidates[node]) {
+        reverse_edges.push_back({neighbor, static_cast<node_id_t>(node)});
+      }
+    }
+    std::sort(reverse_edges.begin(), reverse_edges.end());
+
+    std::vector<size_t> group_offsets = groupOffsets(reverse_edges);
+    _index.parallelFor(0, group_offsets.size() - 1, [&](uint64_t group) {
+      node_id_t target = reverse_edges[group_offsets[group]].first;
+      auto& target_candidates = candidates[target];
+      size_t num_forward = target_candidates.size();
+      for (size_t i = group_offsets[group];
+           i < group_offsets[group + 1] && target_candidates.size() < num_forward + _sample_size; i++) {
+        node_id_t source = reverse_edges[i].second;
+        if (std::find(target_candidates.begin(), target_candidates.begin() + num_forward, source) ==
+            target_candidates.begin() + num_forward) {
+          target_candidates.push_back(source);
+        }
+      }
+    });
+  }
+
+  /**
+   * @brief Joins the candidates of every node and applies the improvements.
+   * @return The number of neighbor list entries that changed.
+   */
+  size_t localJoin() {
+    std::atomic<size_t> num_updates(0);
+    for (size_t chunk_start = 0; chunk_start < _num_nodes; chunk_start += NODES_PER_CHUNK) {
+      size_t chunk_end = std::min(chunk_start + NODES_PER_CHUNK, _num_nodes);
+      std::vector<std::vector<Update>> node_updates(chunk_end - chunk_start);
+
+      _index.parallelFor(chunk_start, chunk_end, [&](uint64_t node) {
+        const auto& new_candidates = _new_candidates[node];
+        const auto& old_candidates = _old_candidates[node];
+        auto& updates = node_updates[node - chunk_start];
+        auto join = [&](node_id_t a, node_id_t b) {
+          if (a == b) {
+            return;
+          }
+          float dist = distance(a, b);
+          if (dist < _neighbors[(a + 1) * _k - 1].distance) {
+            updates.push_back({a, {dist, b}});
+          }
+          if (dist < _neighbors[(b + 1) * _k - 1].distance) {
+            updates.push_back({b, {dist, a}});
+          }
+        };
+        for (size_t i = 0; i < new_candidates.size(); i++) {
+          for (size_t j = i + 1; j < new_candidates.size(); j++) {
+            join(new_candidates[i], new_candidates[j]);
+          }
+          for (node_id_t old_candidate : old_candidates) {
+            join(new_candidates[i], old_candidate);
+          }
+        }
+      });
+
+      std::vector<Update> updates;
+      for (auto& chunk_updates : node_updates) {
+        updates.insert(updates.end(), chunk_updates.begin(), chunk_updates.end());
+      }
+      node_updates.clear();
+      std::sort(updates.begin(), updates.end());
+
+      std::vector<size_t> group_offsets = groupOffsets(updates);
+      _index.parallelFor(0, group_offsets.size() - 1, [&](uint64_t group) {
+        size_t group_updates = 0;
+        for (size_t i = group_offsets[group]; i < group_offsets[group + 1]; i++) {
+          const auto& [target, candidate] = updates[i];
+          group_updates += insertNeighbor(target, candidate.first, candidate.second);
+        }
+        num_updates += group_updates;
+      });
+    }
+    return num_updates;
+  }
+
+  // Offsets of the runs of equal targets in a sorted vector of pairs, followed
+  // by its size.
+  template <typename pair_t>
+  static std::vector<size_t> groupOffsets(const std::vector<pair_t>& sorted_pairs) {
+    std::vector<size_t> group_offsets;
+    for (size_t i = 0; i < sorted_pairs.size(); i++) {
+      if (i == 0 || sorted_pairs[i].first != sorted_pairs[i - 1].first) {
+        group_offsets.push_back(i);
+      }
+    }
+    group_offsets.push_back(sorted_pairs.size());
+    return group_offsets;
+  }
+
+  index_t& _index;
+  NNDescentParameters _parameters;
+  size_t _num_nodes;
+  size_t _k;
+  size_t _sample_size;
+
+  // Row-major (num_nodes x k) neighbor lists, closest first. Unfilled entries
+  // point to the node itself at the maximum distance.
+  std::vector<Neighbor> _neighbors;
+  std::vector<std::vector<node_id_t>> _new_candidates;
+  std::vector<std::vector<node_id_t>> _old_candidates;
+};
+
+/**
+ * @brief Links the allocated nodes of `index` with NN-Descent, using the
+ * index's threads. For static indexes built in one batch this is usually much
+ * faster than inserting every vector with `Index::add`.
+ *
+ * @exception std::invalid_argument Thrown if the sample rate is not in (0, 1].
+ */
+template <typename dist_t, typename label_t, typename node_id_t>
+void nnDescent(Index<dist_t, label_t, node_id_t>& index,
+               const NNDescentParameters& parameters = NNDescentParameters()) {
+  NNDescent<dist_t, label_t, node_id_t>(index, parameters).build();
+}
+
+}  // namespace flatnav::build
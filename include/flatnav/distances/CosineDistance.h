@@ -0,0 +1,125 @@
+#pragma once
+
+#include <flatnav/distances/DistanceInterface.h>
+#include <flatnav/distances/IPDistanceDispatcher.h>
+#include <flatnav/util/Datatype.h>
+#include <cereal/access.hpp>
+#include <cereal/cereal.hpp>
+#include <cmath>
+#include <cstddef>  // for size_t
+#include <iostream>
+#include <vector>
+
+namespace flatnav::distances {
+
+// The cosine distance 1 - <x, y> / (|x| |y|). Vectors are normalized once,
+// when they are stored, and queries once per search, so that distances are
+// inner product distances between unit vectors, computed with the inner
+// product kernels. Vectors and queries are float32 and can be stored as
+// float32, float16 or bfloat16. The zero vector is stored as is, at distance
+// 1 from every vector.
+
+using util::DataType;
+using util::type_for_data_type;
+
+template <DataType data_type = DataType::float32>
+class CosineDistance : public DistanceInterface<CosineDistance<data_type>> {
+  static_assert(data_type == DataType::float32 || util::isHalfPrecision(data_type),
+                "The cosine distance needs float32, float16 or bfloat16 data.");
+
+  friend class DistanceInterface<CosineDistance>;
+  enum { DISTANCE_ID = 2 };
+
+ public:
+  CosineDistance() = default;
+  CosineDistance(size_t dim) : _dimension(dim), _data_size_bytes(dim * util::size(data_type)) {
+    resolveDistanceFunctions();
+  }
+
+  static std::unique_ptr<CosineDistance<data_type>> create(size_t dim) {
+    return std::make_unique<CosineDistance<data_type>>(dim);
+  }
+
+  // Both vectors must be normalized: x is a stored vector, or a query
+  // prepared by transformQuery when the distance is asymmetric.
+  float distanceImpl(const void* x, const void* y, bool asymmetric = false) const {
+    return (asymmetric ? _query_distance_function : _distance_function)(x, y, _dimension);
+  }
+
+  DataType getDataTypeImpl() const { return data_type; }
+
+ private:
+  size_t _dimension;
+  size_t _data_size_bytes;
+  // The kernel between stored vectors, and the one from a query, which is
+  // float32 for 16-bit float data.
+  util::DistanceFunction _distance_function = nullptr;
+  util::DistanceFunction _query_distance_function = nullptr;
+
+  friend class cereal::access;
+
+  template <typename Archive>
+  void serialize(Archive& ar) {
+    ar(_dimension, _data_size_bytes);
+    resolveDistanceFunctions();
+  }
+
+  // Picks the kernels for this CPU and dimension once, so that distance
+  // computations are a single indirect call.
+  void resolveDistanceFunctions() {
+    using data_t = typename type_for_data_type<data_type>::type;
+    _distance_function = IPDistanceDispatcher::resolve<data_t, data_t>(_dimension);
+    if constexpr (util::isHalfPrecision(data_type)) {
+      _query_distance_function = IPDistanceDispatcher::resolve<float, data_t>(_dimension);
+    } else {
+      _query_distance_function = _distance_function;
+    }
+  }
+
+  inline size_t getDimension() const { return _dimension; }
+
+  size_t dataSizeImpl() { return _data_size_bytes; }
+
+  // 1 / |x|, or 1 for the zero vector.
+  float inverseNorm(const float* x) const {
+    float squared_norm = 0;
+    for (size_t i = 0; i < _dimension; i++) {
+      squared_norm += x[i] * x[i];
+    }
+    return squared_norm > 0 ? 1.0f / std::sqrt(squared_norm) : 1.0f;
+  }
+
+  void transformDataImpl(void* dst, const void* src) {
+    const float* vector = static_cast<const float*>(src);
+    float scale = inverseNorm(vector);
+    auto* destination = static_cast<typename type_for_data_type<data_type>::type*>(dst);
+    for (size_t i = 0; i < _dimension; i++) {
+      if constexpr (util::isHalfPrecision(data_type)) {
+        util::fromFloat(vector[i] * scale, destination[i]);
+      } else {
+        destination[i] = vector[i] * scale;
+      }
+    }
+  }
+
+  const void* transformQueryImpl(const void* query, std::vector<char>& buffer) {
+    buffer.resize(_dimension * sizeof(float));
+    const float* vector = static_cast<const float*>(query);
+    float* normalized = reinterpret_cast<float*>(buffer.data());
+    float scale = inverseNorm(vector);
+    for (size_t i = 0; i < _dimension; i++) {
+      normalized[i] = vector[i] * scale;
+    }
+    return normalized;
+  }
+
+  void getSummaryImpl() {
+    std::cout << "\nCosineDistance Parameters" << std::flush;
+    std::cout << "\n-----------------------------"
+              << "\n"
+              << std::flush;
+    std::cout << "Dimension: " << _dimension << "\n" << std::flush;
+  }
+};
+
+}  // namespace flatnav::distances
@@ -4,6 +4,7 @@
 #include <cstddef>  // for size_t
 #include <fstream>  // for ifstream, ofstream
 #include <iostream>
+#include <vector>
 #include <flatnav/util/Datatype.h>
 
 
@@ -51,11 +52,23 @@ class DistanceInterface {
     static_cast<T*>(this)->transformDataImpl(destination, src);
   }
 
+  // This returns the query in the form that asymmetric distances take. The
+  // index prepares each query once, before its search. Most distances use the
+  // query as given, but some (e.g. cosine, which normalizes it) write the
+  // prepared query to `buffer` and return a pointer into it.
+  const void* transformQuery(const void* query, std::vector<char>& buffer) {
+    return static_cast<T*>(this)->transformQueryImpl(query, buffer);
+  }
+
   // Serializes the distance function to disk.
   template <typename Archive>
   void serialize(Archive& archive) {
     static_cast<T*>(this)->template serialize<Archive>(archive);
   }
+
+ protected:
+  // Default for distances that do not preprocess queries.
+  const void* transformQueryImpl(const void* query, [[maybe_unused]] std::vector<char>& buffer) { return query; }
 };
 
 }  // namespace flatnav::distances
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <flatnav/util/Datatype.h>
 #include <flatnav/util/InnerProductSimdExtensions.h>
 #include <flatnav/util/Macros.h>
+#include <type_traits>
 
 namespace flatnav::distances {
 
@@ -15,88 +16,176 @@ static float defaultInnerProduct(const T* x, const T* y, const size_t& dimension
   return 1.0f - inner_product;
 }
 
+// defaultInnerProduct with the signature of the kernels.
+template <typename T>
+static float defaultInnerProductKernel(const void* x, const void* y, const size_t& dimension) {
+  return defaultInnerProduct<T>(static_cast<const T*>(x), static_cast<const T*>(y), dimension);
+}
+
 template <typename T>
 struct InnerProductImpl {
+  // See SquaredL2Impl::resolve.
+  static util::DistanceFunction resolve([[maybe_unused]] const size_t& dimension) {
+    return defaultInnerProductKernel<T>;
+  }
+
   static float computeDistance(const T* x, const T* y, const size_t& dimension) {
-    return defaultInnerProduct<T>(x, y, dimension);
+    return resolve(dimension)(x, y, dimension);
   }
 };
 
+// Specialization of InnerProductImpl for the float type. The AVX-512 and AVX2
+// kernels handle any dimension; the SSE kernels depend on it.
 template <>
 struct InnerProductImpl<float> {
-  static float computeDistance(const float* x, const float* y, const size_t& dimension) {
-#if defined(USE_AVX512)
-    if (platformSupportsAvx512()) {
-      if (dimension % 16 == 0) {
-        return util::computeIP_Avx512(x, y, dimension);
-      }
-      if (dimension % 4 == 0) {
-#if defined(USE_AVX)
-        return util::computeIP_Avx_4aligned(x, y, dimension);
-#else
-        return util::computeIP_Sse4Aligned(x, y, dimension);
-#endif
-      } else if (dimension > 16) {
-        return util::computeIP_SseWithResidual_16(x, y, dimension);
-      } else if (dimension > 4) {
-        return util::computeIP_SseWithResidual_4(x, y, dimension);
-      }
+  static util::DistanceFunction resolve(const size_t& dimension) {
+#if defined(BUILD_AVX512_KERNELS)
+    if (platformSupportsAvx512Bw()) {
+      return util::computeIP_Avx512;
     }
 #endif
-
-#if defined(USE_AVX)
-    if (platformSupportsAvx()) {
-      if (dimension % 16 == 0) {
-        return util::computeIP_Avx(x, y, dimension);
-      }
-      if (dimension % 4 == 0) {
-        return util::computeIP_Avx_4aligned(x, y, dimension);
-      } else if (dimension > 16) {
-        return util::computeIP_SseWithResidual_16(x, y, dimension);
-      } else if (dimension > 4) {
-        return util::computeIP_SseWithResidual_4(x, y, dimension);
-      }
+#if defined(BUILD_AVX2_KERNELS)
+    if (platformSupportsAvx2()) {
+      return util::computeIP_Avx;
     }
 #endif
-
 #if defined(USE_SSE)
     if (dimension % 16 == 0) {
-      return util::computeIP_Sse(x, y, dimension);
+      return util::computeIP_Sse;
     }
     if (dimension % 4 == 0) {
-      return util::computeIP_Sse_4aligned(x, y, dimension);
+      return util::computeIP_Sse_4aligned;
     } else if (dimension > 16) {
-      return util::computeIP_SseWithResidual_16(x, y, dimension);
+      return util::computeIP_SseWithResidual_16;
     } else if (dimension > 4) {
-      return util::computeIP_SseWithResidual_4(x, y, dimension);
+      return util::computeIP_SseWithResidual_4;
     }
-
 #endif
-    return defaultInnerProduct<float>(x, y, dimension);
+    return defaultInnerProductKernel<float>;
+  }
+
+  static float computeDistance(const float* x, const float* y, const size_t& dimension) {
+    return resolve(dimension)(x, y, dimension);
   }
 };
 
-// TODO: Include SIMD optimized implementations for int8_t.
 template <>
 struct InnerProductImpl<int8_t> {
+  static util::DistanceFunction resolve([[maybe_unused]] const size_t& dimension) {
+#if defined(BUILD_AVX512VNNI_KERNELS)
+    if (platformSupportsAvx512Vnni()) {
+      return util::computeIP_Avx512Vnni_int8;
+    }
+#endif
+#if defined(BUILD_AVX512_KERNELS)
+    if (platformSupportsAvx512Bw()) {
+      return util::computeIP_Avx512_int8;
+    }
+#endif
+#if defined(BUILD_AVX2_KERNELS)
+    if (platformSupportsAvx2()) {
+      return util::computeIP_Avx2_int8;
+    }
+#endif
+#if defined(USE_SSE4_1)
+    return util::computeIP_Sse_int8;
+#endif
+    return defaultInnerProductKernel<int8_t>;
+  }
+
   static float computeDistance(const int8_t* x, const int8_t* y, const size_t& dimension) {
-    return defaultInnerProduct<int8_t>(x, y, dimension);
+    return resolve(dimension)(x, y, dimension);
   }
 };
 
-// TODO: Include SIMD optimized implementations for uint8_t.
 template <>
 struct InnerProductImpl<uint8_t> {
+  static util::DistanceFunction resolve([[maybe_unused]] const size_t& dimension) {
+#if defined(BUILD_AVX512VNNI_KERNELS)
+    if (platformSupportsAvx512Vnni()) {
+      return util::computeIP_Avx512Vnni_uint8;
+    }
+#endif
+#if defined(BUILD_AVX512_KERNELS)
+    if (platformSupportsAvx512Bw()) {
+      return util::computeIP_Avx512_uint8;
+    }
+#endif
+#if defined(BUILD_AVX2_KERNELS)
+    if (platformSupportsAvx2()) {
+      return util::computeIP_Avx2_uint8;
+    }
+#endif
+#if defined(USE_SSE4_1)
+    return util::computeIP_Sse_uint8;
+#endif
+    return defaultInnerProductKernel<uint8_t>;
+  }
+
   static float computeDistance(const uint8_t* x, const uint8_t* y, const size_t& dimension) {
-    return defaultInnerProduct<uint8_t>(x, y, dimension);
+    return resolve(dimension)(x, y, dimension);
   }
 };
 
+// Inner product distances on 16-bit float data. x is either a float32 query or
+// a vector of the same type as y, and resolve takes its type.
+template <typename T>
+struct HalfPrecisionInnerProductImpl {
+  template <typename query_t>
+  static float defaultDistance(const void* x, const void* y, const size_t& dimension) {
+    const query_t* pointer_x = static_cast<const query_t*>(x);
+    const T* pointer_y = static_cast<const T*>(y);
+    float inner_product = 0;
+    for (size_t i = 0; i < dimension; i++) {
+      inner_product += util::toFloat(pointer_x[i]) * util::toFloat(pointer_y[i]);
+    }
+    return 1.0f - inner_product;
+  }
+
+  template <typename query_t = T>
+  static util::DistanceFunction resolve([[maybe_unused]] const size_t& dimension) {
+#if defined(BUILD_AVX512_KERNELS)
+    if (platformSupportsAvx512Bw()) {
+      return util::computeIP_Avx512_half<query_t, T>;
+    }
+#endif
+#if defined(BUILD_AVX2_KERNELS)
+    if (platformSupportsAvx2()) {
+      return util::computeIP_Avx2_half<query_t, T>;
+    }
+#endif
+    return defaultDistance<query_t>;
+  }
+
+  template <typename query_t>
+  static float computeDistance(const query_t* x, const T* y, const size_t& dimension) {
+    return resolve<query_t>(dimension)(x, y, dimension);
+  }
+};
+
+template <>
+struct InnerProductImpl<util::float16_t> : HalfPrecisionInnerProductImpl<util::float16_t> {};
+
+template <>
+struct InnerProductImpl<util::bfloat16_t> : HalfPrecisionInnerProductImpl<util::bfloat16_t> {};
+
 struct IPDistanceDispatcher {
-  template <typename T>
-  static float dispatch(const T* x, const T* y, const size_t& dimension) {
-    return InnerProductImpl<T>::computeDistance(x, y, dimension);
+  // The implementation is chosen by the type of y, the stored vector. x is a
+  // vector of the same type, or a float32 query for 16-bit float data.
+  // Distances resolve their kernel once; dispatch resolves it on every call.
+  template <typename query_t, typename T>
+  static util::DistanceFunction resolve(const size_t& dimension) {
+    if constexpr (std::is_same_v<query_t, T>) {
+      return InnerProductImpl<T>::resolve(dimension);
+    } else {
+      return InnerProductImpl<T>::template resolve<query_t>(dimension);
+    }
+  }
+
+  template <typename query_t, typename T>
+  static float dispatch(const query_t* x, const T* y, const size_t& dimension) {
+    return resolve<query_t, T>(dimension)(x, y, dimension);
   }
 };
 
-}  // namespace flatnav::distances
\ No newline at end of file
+}  // namespace flatnav::distances
@@ -30,16 +30,17 @@ class InnerProductDistance : public DistanceInterface<InnerProductDistance<data_
  public:
   InnerProductDistance() = default;
   InnerProductDistance(size_t dim)
-      : _dimension(dim), _data_size_bytes(dim * flatnav::util::size(data_type)) {}
+      : _dimension(dim), _data_size_bytes(dim * flatnav::util::size(data_type)) {
+    resolveDistanceFunctions();
+  }
 
   static std::unique_ptr<InnerProductDistance<data_type>> create(size_t dim) {
     return std::make_unique<InnerProductDistance<data_type>>(dim);
   }
 
-  constexpr float distanceImpl(const void* x, const void* y, [[maybe_unused]] bool asymmetric = false) const {
-    return IPDistanceDispatcher::dispatch(static_cast<const typename type_for_data_type<data_type>::type*>(x),
-                                          static_cast<const typename type_for_data_type<data_type>::type*>(y),
-                                          _dimension);
+  // For 16-bit float data, asymmetric distances take a float32 query as x.
+  float distanceImpl(const void* x, const void* y, bool asymmetric = false) const {
+    return (asymmetric ? _query_distance_function : _distance_function)(x, y, _dimension);
   }
 
   DataType getDataTypeImpl() const { return data_type; }
@@ -47,19 +48,44 @@ class InnerProductDistance : public DistanceInterface<InnerProductDistance<data_
  private:
   size_t _dimension;
   size_t _data_size_bytes;
+  // The kernel between stored vectors, and the one from a query, which is
+  // float32 for 16-bit float data.
+  util::DistanceFunction _distance_function = nullptr;
+  util::DistanceFunction _query_distance_function = nullptr;
 
   friend class cereal::access;
 
   template <typename Archive>
   void serialize(Archive& ar) {
     ar(_dimension, _data_size_bytes);
+    resolveDistanceFunctions();
+  }
+
+  // Picks the kernels for this CPU and dimension once, so that distance
+  // computations are a single indirect call.
+  void resolveDistanceFunctions() {
+    using data_t = typename type_for_data_type<data_type>::type;
+    _distance_function = IPDistanceDispatcher::resolve<data_t, data_t>(_dimension);
+    if constexpr (util::isHalfPrecision(data_type)) {
+      _query_distance_function = IPDistanceDispatcher::resolve<float, data_t>(_dimension);
+    } else {
+      _query_distance_function = _distance_function;
+    }
   }
 
   inline size_t getDimension() const { return _dimension; }
 
   size_t dataSizeImpl() { return _data_size_bytes; }
 
-  void transformDataImpl(void* dst, const void* src) { std::memcpy(dst, src, _data_size_bytes); }
+  // 16-bit float data is added as float32 and rounded here.
+  void transformDataImpl(void* dst, const void* src) {
+    if constexpr (util::isHalfPrecision(data_type)) {
+      util::convertFromFloat(static_cast<const float*>(src),
+                             static_cast<typename type_for_data_type<data_type>::type*>(dst), _dimension);
+    } else {
+      std::memcpy(dst, src, _data_size_bytes);
+    }
+  }
 
   void getSummaryImpl() {
     std::cout << "\nInnerProductDistance Parameters" << std::flush;
@@ -3,6 +3,7 @@
 #include <flatnav/util/Datatype.h>
 #include <flatnav/util/Macros.h>
 #include <flatnav/util/SquaredL2SimdExtensions.h>
+#include <type_traits>
 
 namespace flatnav::distances {
 
@@ -16,12 +17,30 @@ static float defaultSquaredL2(const T* x, const T* y, const size_t& dimension) {
   return squared_distance;
 }
 
+// defaultSquaredL2 with the signature of the kernels.
+template <typename T>
+static float defaultSquaredL2Kernel(const void* x, const void* y, const size_t& dimension) {
+  return defaultSquaredL2<T>(static_cast<const T*>(x), static_cast<const T*>(y), dimension);
+}
+
 // This struct provides a generic implementation of computing the squared L2
 // distance
 //  between two arrays of type T.
 // @TODO: We should add constraints to the T type.
 template <typename T>
 struct SquaredL2Impl {
+  /**
+   * Picks the kernel that computes squared L2 distances between arrays of
+   * type T of the given dimension on this CPU. Distances call this once, when
+   * they are constructed, and keep the returned pointer.
+   *
+   * @param dimension The dimension of the arrays.
+   * @return A kernel taking the two arrays and their dimension.
+   */
+  static util::DistanceFunction resolve([[maybe_unused]] const size_t& dimension) {
+    return defaultSquaredL2Kernel<T>;
+  }
+
   /**
    * Computes the squared L2 distance between two arrays of type T.
    *
@@ -31,98 +50,163 @@ struct SquaredL2Impl {
    * @return The squared L2 distance between the two arrays.
    */
   static float computeDistance(const T* x, const T* y, const size_t& dimension) {
-    return defaultSquaredL2<T>(x, y, dimension);
+    return resolve(dimension)(x, y, dimension);
   }
 };
 
-// Specialization of SquaredL2Impl for the float type.
+// Specialization of SquaredL2Impl for the float type. The AVX-512 and AVX2
+// kernels handle any dimension; the SSE kernels depend on it.
 template <>
 struct SquaredL2Impl<float> {
-  static float computeDistance(const float* x, const float* y, const size_t& dimension) {
-#if defined(USE_AVX512)
-    if (platformSupportsAvx512()) {
-      if (dimension % 16 == 0) {
-        return util::computeL2_Avx512(x, y, dimension);
-      }
-      if (dimension % 4 == 0) {
-        return util::computeL2_Sse4Aligned(x, y, dimension);
-      } else if (dimension > 16) {
-        return util::computeL2_SseWithResidual_16(x, y, dimension);
-      } else if (dimension > 4) {
-        return util::computeL2_SseWithResidual_4(x, y, dimension);
-      }
+  static util::DistanceFunction resolve(const size_t& dimension) {
+#if defined(BUILD_AVX512_KERNELS)
+    if (platformSupportsAvx512Bw()) {
+      return util::computeL2_Avx512;
     }
 #endif
-
-#if defined(USE_AVX)
-    if (platformSupportsAvx()) {
-      if (dimension % 16 == 0) {
-        return util::computeL2_Avx2(x, y, dimension);
-      }
-      if (dimension % 4 == 0) {
-        return util::computeL2_Sse4Aligned(x, y, dimension);
-      } else if (dimension > 16) {
-        return util::computeL2_SseWithResidual_16(x, y, dimension);
-      } else if (dimension > 4) {
-        return util::computeL2_SseWithResidual_4(x, y, dimension);
-      }
+#if defined(BUILD_AVX2_KERNELS)
+    if (platformSupportsAvx2()) {
+      return util::computeL2_Avx2;
     }
 #endif
-
 #if defined(USE_SSE)
     if (dimension % 16 == 0) {
-      return util::computeL2_Sse(x, y, dimension);
+      return util::computeL2_Sse;
     }
     if (dimension % 4 == 0) {
-      return util::computeL2_Sse4Aligned(x, y, dimension);
+      return util::computeL2_Sse4Aligned;
     } else if (dimension > 16) {
-      return util::computeL2_SseWithResidual_16(x, y, dimension);
+      return util::computeL2_SseWithResidual_16;
     } else if (dimension > 4) {
-      return util::computeL2_SseWithResidual_4(x, y, dimension);
+      return util::computeL2_SseWithResidual_4;
     }
-#else
-    return defaultSquaredL2<float>(x, y, dimension);
 #endif
+    return defaultSquaredL2Kernel<float>;
+  }
+
+  static float computeDistance(const float* x, const float* y, const size_t& dimension) {
+    return resolve(dimension)(x, y, dimension);
   }
 };
 
 template <>
 struct SquaredL2Impl<int8_t> {
-  static float computeDistance(const int8_t* x, const int8_t* y, const size_t& dimension) {
-// #if defined(USE_AVX512BW) && defined(USE_AVX512VNNI)
-//     if (platformSupportsAvx512()) {
-//       return flatnav::util::computeL2_Avx512_int8(x, y, dimension);
-//     }
-// #endif
-#if defined(USE_SSE_4_1)
-    // This requires some advanced SSE4.1 instructions, such as _mm_cvtepi8_epi16
-    // Reference: https://doc.rust-lang.org/beta/core/arch/x86_64/fn._mm_cvtepi8_epi16.html
-    return flatnav::util::computeL2_Sse_int8(x, y, dimension);
+  static util::DistanceFunction resolve([[maybe_unused]] const size_t& dimension) {
+#if defined(BUILD_AVX512VNNI_KERNELS)
+    if (platformSupportsAvx512Vnni()) {
+      return util::computeL2_Avx512Vnni_int8;
+    }
 #endif
-    return defaultSquaredL2<int8_t>(x, y, dimension);
+#if defined(BUILD_AVX512_KERNELS)
+    if (platformSupportsAvx512Bw()) {
+      return util::computeL2_Avx512_int8;
+    }
+#endif
+#if defined(BUILD_AVX2_KERNELS)
+    if (platformSupportsAvx2()) {
+      return util::computeL2_Avx2_int8;
+    }
+#endif
+#if defined(USE_SSE4_1)
+    return util::computeL2_Sse_int8;
+#endif
+    return defaultSquaredL2Kernel<int8_t>;
+  }
+
+  static float computeDistance(const int8_t* x, const int8_t* y, const size_t& dimension) {
+    return resolve(dimension)(x, y, dimension);
   }
 };
 
 template <>
 struct SquaredL2Impl<uint8_t> {
+  static util::DistanceFunction resolve([[maybe_unused]] const size_t& dimension) {
+#if defined(BUILD_AVX512VNNI_KERNELS)
+    if (platformSupportsAvx512Vnni()) {
+      return util::computeL2_Avx512Vnni_uint8;
+    }
+#endif
+#if defined(BUILD_AVX512_KERNELS)
+    if (platformSupportsAvx512Bw()) {
+      return util::computeL2_Avx512_Uint8;
+    }
+#endif
+#if defined(BUILD_AVX2_KERNELS)
+    if (platformSupportsAvx2()) {
+      return util::computeL2_Avx2_uint8;
+    }
+#endif
+#if defined(USE_SSE4_1)
+    return util::computeL2_Sse_uint8;
+#endif
+    return defaultSquaredL2Kernel<uint8_t>;
+  }
+
   static float computeDistance(const uint8_t* x, const uint8_t* y, const size_t& dimension) {
-#if defined(USE_AVX512)
-    if (platformSupportsAvx512()) {
-      if (dimension % 64 == 0) {
-        return util::computeL2_Avx512_Uint8(x, y, dimension);
-      }
+    return resolve(dimension)(x, y, dimension);
+  }
+};
+
+// Squared L2 distances on 16-bit float data. x is either a float32 query or
+// a vector of the same type as y, and resolve takes its type.
+template <typename T>
+struct HalfPrecisionSquaredL2Impl {
+  template <typename query_t>
+  static float defaultDistance(const void* x, const void* y, const size_t& dimension) {
+    const query_t* pointer_x = static_cast<const query_t*>(x);
+    const T* pointer_y = static_cast<const T*>(y);
+    float squared_distance = 0;
+    for (size_t i = 0; i < dimension; i++) {
+      float difference = util::toFloat(pointer_x[i]) - util::toFloat(pointer_y[i]);
+      squared_distance += difference * difference;
+    }
+    return squared_distance;
+  }
+
+  template <typename query_t = T>
+  static util::DistanceFunction resolve([[maybe_unused]] const size_t& dimension) {
+#if defined(BUILD_AVX512_KERNELS)
+    if (platformSupportsAvx512Bw()) {
+      return util::computeL2_Avx512_half<query_t, T>;
+    }
+#endif
+#if defined(BUILD_AVX2_KERNELS)
+    if (platformSupportsAvx2()) {
+      return util::computeL2_Avx2_half<query_t, T>;
     }
 #endif
+    return defaultDistance<query_t>;
+  }
 
-    return defaultSquaredL2<uint8_t>(x, y, dimension);
+  template <typename query_t>
+  static float computeDistance(const query_t* x, const T* y, const size_t& dimension) {
+    return resolve<query_t>(dimension)(x, y, dimension);
   }
 };
 
+template <>
+struct SquaredL2Impl<util::float16_t> : HalfPrecisionSquaredL2Impl<util::float16_t> {};
+
+template <>
+struct SquaredL2Impl<util::bfloat16_t> : HalfPrecisionSquaredL2Impl<util::bfloat16_t> {};
+
 struct L2DistanceDispatcher {
-  template <typename T>
-  static float dispatch(const T* x, const T* y, const size_t& dimension) {
-    return SquaredL2Impl<T>::computeDistance(x, y, dimension);
+  // The implementation is chosen by the type of y, the stored vector. x is a
+  // vector of the same type, or a float32 query for 16-bit float data.
+  // Distances resolve their kernel once; dispatch resolves it on every call.
+  template <typename query_t, typename T>
+  static util::DistanceFunction resolve(const size_t& dimension) {
+    if constexpr (std::is_same_v<query_t, T>) {
+      return SquaredL2Impl<T>::resolve(dimension);
+    } else {
+      return SquaredL2Impl<T>::template resolve<query_t>(dimension);
+    }
+  }
+
+  template <typename query_t, typename T>
+  static float dispatch(const query_t* x, const T* y, const size_t& dimension) {
+    return resolve<query_t, T>(dimension)(x, y, dimension);
   }
 };
 
-}  // namespace flatnav::distances
\ No newline at end of file
+}  // namespace flatnav::distances
@@ -13,8 +13,8 @@
 #include <type_traits>
 
 // This is the base distance function implementation for the L2 distance on
-// floating-point inputs. We provide specializations that use SIMD when
-// supported by the compiler and compatible with the input _dimension.
+// floating-point inputs. The SIMD kernel supported by the CPU is picked once,
+// when the distance is constructed or loaded.
 
 namespace flatnav::distances {
 
@@ -29,7 +29,9 @@ class SquaredL2Distance : public DistanceInterface<SquaredL2Distance<data_type>>
 
  public:
   SquaredL2Distance() = default;
-  SquaredL2Distance(size_t dim) : _dimension(dim), _data_size_bytes(dim * util::size(data_type)) {}
+  SquaredL2Distance(size_t dim) : _dimension(dim), _data_size_bytes(dim * util::size(data_type)) {
+    resolveDistanceFunctions();
+  }
 
   static std::unique_ptr<SquaredL2Distance<data_type>> create(size_t dim) {
     return std::make_unique<SquaredL2Distance<data_type>>(dim);
@@ -37,10 +39,9 @@ class SquaredL2Distance : public DistanceInterface<SquaredL2Distance<data_type>>
 
   inline constexpr size_t getDimension() const { return _dimension; }
 
-  constexpr float distanceImpl(const void* x, const void* y, [[maybe_unused]] bool asymmetric = false) const {
-    return L2DistanceDispatcher::dispatch(static_cast<const typename type_for_data_type<data_type>::type*>(x),
-                                          static_cast<const typename type_for_data_type<data_type>::type*>(y),
-                                          _dimension);
+  // For 16-bit float data, asymmetric distances take a float32 query as x.
+  float distanceImpl(const void* x, const void* y, bool asymmetric = false) const {
+    return (asymmetric ? _query_distance_function : _distance_function)(x, y, _dimension);
   }
 
   inline DataType getDataTypeImpl() const { return data_type; }
@@ -48,18 +49,41 @@ class SquaredL2Distance : public DistanceInterface<SquaredL2Distance<data_type>>
  private:
   size_t _dimension;
   size_t _data_size_bytes;
+  // The kernel between stored vectors, and the one from a query, which is
+  // float32 for 16-bit float data.
+  util::DistanceFunction _distance_function = nullptr;
+  util::DistanceFunction _query_distance_function = nullptr;
 
   friend class ::cereal::access;
 
   template <typename Archive>
   void serialize(Archive& ar) {
     ar(_dimension, _data_size_bytes);
+    resolveDistanceFunctions();
+  }
+
+  // Picks the kernels for this CPU and dimension once, so that distance
+  // computations are a single indirect call.
+  void resolveDistanceFunctions() {
+    using data_t = typename type_for_data_type<data_type>::type;
+    _distance_function = L2DistanceDispatcher::resolve<data_t, data_t>(_dimension);
+    if constexpr (util::isHalfPrecision(data_type)) {
+      _query_distance_function = L2DistanceDispatcher::resolve<float, data_t>(_dimension);
+    } else {
+      _query_distance_function = _distance_function;
+    }
   }
 
   inline size_t dataSizeImpl() { return _data_size_bytes; }
 
+  // 16-bit float data is added as float32 and rounded here.
   inline void transformDataImpl(void* destination, const void* src) {
-    std::memcpy(destination, src, _data_size_bytes);
+    if constexpr (util::isHalfPrecision(data_type)) {
+      util::convertFromFloat(static_cast<const float*>(src),
+                             static_cast<typename type_for_data_type<data_type>::type*>(destination), _dimension);
+    } else {
+      std::memcpy(destination, src, _data_size_bytes);
+    }
   }
 
   void getSummaryImpl() {
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <flatnav/distances/DistanceInterface.h>
+#include <flatnav/util/CsrGraph.h>
+#include <flatnav/util/GraphStats.h>
+#include <flatnav/util/LabelMap.h>
 #include <flatnav/util/Macros.h>
 #include <flatnav/util/Multithreading.h>
+#include <flatnav/util/NpyReader.h>
 #include <flatnav/util/Reordering.h>
 #include <flatnav/util/VisitedSetPool.h>
 #include <flatnav/util/Datatype.h>
@@ -18,9 +22,12 @@
 #include <limits>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <new>
 #include <queue>
 #include <set>
 #include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include <optional>
@@ -29,9 +36,15 @@ using flatnav::distances::DistanceInterface;
 using flatnav::util::VisitedSet;
 using flatnav::util::VisitedSetPool;
 using flatnav::util::DataType;
+using flatnav::util::LabelMap;
 
 namespace flatnav {
 
+namespace build {
+template <typename dist_t, typename label_t, typename node_id_t>
+class NNDescent;
+}  // namespace build
+
 // Algorithm to select beam search entry point.
 enum class EntryPolicy {
   Random,
@@ -41,13 +54,36 @@ enum class EntryPolicy {
   Ideal
 };
 
+// Parameters of the neighbor selection heuristic used to link nodes.
+struct PruningConfig {
+  // A candidate is pruned if an already selected neighbor is closer to it than
+  // its distance to the node divided by alpha. 1 is the HNSW heuristic. Larger
+  // values, as in DiskANN's RobustPrune, keep more long edges, which lowers the
+  // number of hops per search at the cost of a higher degree. This assumes
+  // non-negative distances.
+  float alpha = 1.0f;
+  // Fill the slots left after pruning with the closest pruned candidates
+  // (HNSW's keepPrunedConnections).
+  bool keep_pruned = false;
+  // Number of links selected for a new node. 0 selects M / 2.
+  size_t forward_degree = 0;
+  // Number of links kept when the full link list of a node is pruned to make
+  // room for a back-edge. 0 keeps M. A smaller budget leaves free slots, so
+  // that the next back-edges do not trigger another pruning.
+  size_t backward_degree = 0;
+};
+
 // dist_t: A distance function implementing DistanceInterface.
 // label_t: A fixed-width data type for the label (meta-data) of each point.
-template <typename dist_t, typename label_t>
+// node_id_t: The unsigned integral type of the internal node numbering scheme.
+// It is stored in every link, so uint32_t (the default) keeps nodes compact;
+// use uint64_t only for indexes with more than 2^32 - 1 nodes.
+template <typename dist_t, typename label_t, typename node_id_t = uint32_t>
 class Index {
+  static_assert(std::is_integral_v<node_id_t> && std::is_unsigned_v<node_id_t>,
+                "node_id_t must be an unsigned integral type.");
+
   typedef std::pair<float, label_t> dist_label_t;
-  // internal node numbering scheme. We might need to change this to uint64_t
-  typedef uint32_t node_id_t;
   typedef std::pair<float, node_id_t> dist_node_t;
 
   // NOTE: by default this is a max-heap. We could make this a min-heap
@@ -72,15 +108,32 @@ class Index {
   // after benchmarking - it's slightly more cache-efficient than others.
   size_t _node_size_bytes;
   size_t _max_node_count;  // Determines size of internal pre-allocated memory
-  size_t _cur_num_nodes;
+  // Nodes [0, _cur_num_nodes) are fully written and may be read by searches.
+  // Ids are handed out by _num_reserved_nodes and published in id order, so
+  // _cur_num_nodes <= _num_reserved_nodes at all times.
+  std::atomic<size_t> _cur_num_nodes;
+  std::atomic<size_t> _num_reserved_nodes;
   std::unique_ptr<DistanceInterface<dist_t>> _distance;
-  std::mutex _index_data_guard;
 
   uint32_t _num_threads;
 
   // Remembers which nodes we've visited, to avoid re-computing distances.
-  VisitedSetPool* _visited_set_pool;
+  VisitedSetPool<node_id_t>* _visited_set_pool;
   std::vector<std::mutex> _node_links_mutexes;
+
+  // Optional cache of the distance from every node to each of its M links,
+  // laid out like the links (see enableLinkDistances). Values in self-loop
+  // slots are meaningless.
+  std::unique_ptr<float[]> _link_distances;
+
+  // Optional reverse index from labels to node ids (see enableLabelLookup).
+  std::unique_ptr<LabelMap<label_t, node_id_t>> _label_map;
+  mutable std::shared_mutex _label_map_guard;
+
+  // Composition of every reordering applied to the index: node i before the
+  // first reordering is now node _permutation[i]. Empty if the index was never
+  // reordered. Saved with the index.
+  std::vector<node_id_t> _permutation;
   
   // Maintain most frequently accessed nodes (e.g., hubs).
   struct CompareByFrequency {
@@ -92,13 +145,17 @@ class Index {
     }
   };
   
+  // The top-frequency tree is only maintained under EntryPolicy::Frequency.
+  // It is shared by all threads, so it has its own guard.
   static constexpr uint32_t _num_top_nodes = 100;
   std::vector<uint32_t> _node_frequencies;
   std::multiset<node_id_t, CompareByFrequency> _top_node_frequencies;
+  std::mutex _top_node_frequencies_guard;
 
   bool _collect_stats = false;
   DataType _data_type;
-  EntryPolicy _entry_policy;
+  EntryPolicy _entry_policy = EntryPolicy::Strided;
+  PruningConfig _pruning;
 
   // NOTE: These metrics are meaningful the most with single-threaded search.
   // With multi-threaded search, for instance, the number of distance computations will 
@@ -123,15 +180,19 @@ class Index {
         _data_size_bytes(other._data_size_bytes),
         _node_size_bytes(other._node_size_bytes),
         _max_node_count(other._max_node_count),
-        _cur_num_nodes(other._cur_num_nodes),
+        _cur_num_nodes(other._cur_num_nodes.load()),
+        _num_reserved_nodes(other._num_reserved_nodes.load()),
         _distance(std::move(other._distance)),
-        _index_data_guard(std::move(other._index_data_guard)),
         _num_threads(other._num_threads),
         _visited_set_pool(std::move(other._visited_set_pool)),
         _node_links_mutexes(std::move(other._node_links_mutexes)),
+        _link_distances(std::move(other._link_distances)),
+        _label_map(std::move(other._label_map)),
+        _permutation(std::move(other._permutation)),
         _node_frequencies(std::move(other._node_frequencies)),
         _top_node_frequencies(std::move(other._top_node_frequencies)),
-        _entry_policy(other._entry_policy) {
+        _entry_policy(other._entry_policy),
+        _pruning(other._pruning) {
     other._index_memory = nullptr;
     other._visited_set_pool = nullptr;
   }
@@ -146,15 +207,19 @@ class Index {
       _data_size_bytes = other._data_size_bytes;
       _node_size_bytes = other._node_size_bytes;
       _max_node_count = other._max_node_count;
-      _cur_num_nodes = other._cur_num_nodes;
+      _cur_num_nodes = other._cur_num_nodes.load();
+      _num_reserved_nodes = other._num_reserved_nodes.load();
       _distance = std::move(other._distance);
-      _index_data_guard = std::move(other._index_data_guard);
       _num_threads = other._num_threads;
       _visited_set_pool = std::move(other._visited_set_pool);
       _node_links_mutexes = std::move(other._node_links_mutexes);
+      _link_distances = std::move(other._link_distances);
+      _label_map = std::move(other._label_map);
+      _permutation = std::move(other._permutation);
       _node_frequencies = std::move(other._node_frequencies);
       _top_node_frequencies = std::move(other._top_node_frequencies);
       _entry_policy = other._entry_policy;
+      _pruning = other._pruning;
 
       other._index_memory = nullptr;
       other._visited_set_pool = nullptr;
@@ -164,11 +229,18 @@ class Index {
 
   template <typename Archive>
   void serialize(Archive& archive) {
-    archive(_data_type, _M, _data_size_bytes, _node_size_bytes, _max_node_count, _cur_num_nodes, *_distance);
+    size_t cur_num_nodes = _cur_num_nodes;
+    archive(_data_type, _M, _data_size_bytes, _node_size_bytes, _max_node_count, cur_num_nodes, *_distance);
 
     // Serialize the allocated memory for the index & query.
     uint64_t total_mem = static_cast<uint64_t>(_node_size_bytes) * static_cast<uint64_t>(_max_node_count);
     archive(cereal::binary_data(_index_memory, total_mem));
+
+    // Appended after the nodes so that older files, which end here, still load.
+    uint64_t permutation_size = _permutation.size();
+    archive(permutation_size);
+    _permutation.resize(permutation_size);
+    archive(cereal::binary_data(_permutation.data(), permutation_size * sizeof(node_id_t)));
   }
 
  public:
@@ -186,16 +258,23 @@ class Index {
    * @param max_edges_per_node The maximum number of links per node.
    * @param collect_stats Flag indicating whether to collect statistics during
    * the search process.
+   * @param data_type The data type of the stored vectors.
+   * @param entry_policy The algorithm used to select beam search entry points.
+   * @param pruning The neighbor selection parameters used to build the graph.
+   *
+   * @exception std::invalid_argument Thrown if the pruning parameters are
+   * invalid or if `dataset_size` does not fit in node_id_t.
    */
-  Index(std::unique_ptr<DistanceInterface<dist_t>> dist, int dataset_size, int max_edges_per_node,
+  Index(std::unique_ptr<DistanceInterface<dist_t>> dist, size_t dataset_size, size_t max_edges_per_node,
         bool collect_stats = false, DataType data_type = DataType::float32,
-        EntryPolicy entry_policy = EntryPolicy::Strided)
+        EntryPolicy entry_policy = EntryPolicy::Strided, PruningConfig pruning = PruningConfig())
       : _M(max_edges_per_node),
         _max_node_count(dataset_size),
         _cur_num_nodes(0),
+        _num_reserved_nodes(0),
         _distance(std::move(dist)),
         _num_threads(1),
-        _visited_set_pool(new VisitedSetPool(
+        _visited_set_pool(new VisitedSetPool<node_id_t>(
             /* initial_pool_size = */ 1,
             /* num_elements = */ dataset_size)),
         _node_links_mutexes(dataset_size),
@@ -203,7 +282,18 @@ class Index {
         _top_node_frequencies(CompareByFrequency(_node_frequencies)),
         _collect_stats(collect_stats),
         _data_type(data_type),
-        _entry_policy(entry_policy) {
+        _entry_policy(entry_policy),
+        _pruning(pruning) {
+
+    if (_max_node_count > static_cast<size_t>(std::numeric_limits<node_id_t>::max())) {
+      throw std::invalid_argument("dataset_size does not fit in node_id_t. Use a wider node id type.");
+    }
+    if (!(_pruning.alpha >= 1.0f)) {
+      throw std::invalid_argument("Pruning alpha must be greater than or equal to 1.");
+    }
+    if (_pruning.forward_degree > _M || _pruning.backward_degree > _M) {
+      throw std::invalid_argument("Pruning degrees must not exceed max_edges_per_node.");
+    }
 
     // Get the size in bytes of metadata vectors.
     size_t mutexes_size_bytes = _node_links_mutexes.size() * sizeof(std::mutex);
@@ -233,7 +323,7 @@ class Index {
     }
 
     std::istringstream iss(line);
-    int num_vertices, num_edges;
+    uint64_t num_vertices, num_edges;
     iss >> num_vertices >> num_vertices >> num_edges;
 
     // check that the number of vertices in the mtx file matches the number of
@@ -251,7 +341,7 @@ class Index {
           "the number of links per node.");
     }
 
-    int u, v;
+    uint64_t u, v;
     while (input_file >> u >> v) {
       // Adjust for 1-based indexing in Matrix Market format
       u--;
@@ -264,6 +354,9 @@ class Index {
       for (size_t i = 0; i < _M; i++) {
         if (links[i] == u) {
           links[i] = v;
+          if (_link_distances) {
+            getLinkDistances(u)[i] = _distance->distance(/* x = */ getNodeData(u), /* y = */ getNodeData(v));
+          }
           break;
         }
       }
@@ -272,11 +365,97 @@ class Index {
     input_file.close();
   }
 
-  std::vector<std::vector<uint32_t>> getGraphOutdegreeTable() {
-    std::vector<std::vector<uint32_t>> outdegree_table(_cur_num_nodes);
+  /**
+   * @brief Builds the graph links from a precomputed kNN graph, e.g. one
+   * computed offline on a GPU. The nodes must already be allocated (see
+   * `allocateNode`), and row i of `neighbors` lists the nearest neighbors of
+   * node i, closest first. Invalid entries (negative, out of range, the node
+   * itself, duplicates) are skipped, so rows may be padded with -1. Rows are
+   * processed in parallel.
+   *
+   * @param neighbors A row-major (num_nodes x k) matrix of node ids.
+   * @param num_nodes The number of rows. Must be the number of nodes in the
+   * index.
+   * @param k The number of neighbors per row. It may exceed M.
+   * @param prune If true, links are selected from each row with the neighbor
+   * selection heuristic. Otherwise the first entries of each row are kept.
+   * @param add_reverse_edges If true, every selected link is also added in the
+   * reverse direction, pruning full link lists as during construction. Each
+   * node then selects `forward_degree` links instead of M, as in `add`.
+   *
+   * @exception std::invalid_argument Thrown if `num_nodes` does not match the
+   * number of nodes in the index.
+   */
+  template <typename neighbor_t>
+  void importKnnGraph(const neighbor_t* neighbors, size_t num_nodes, size_t k, bool prune = true,
+                      bool add_reverse_edges = true) {
+    if (num_nodes != _cur_num_nodes) {
+      throw std::invalid_argument("The kNN graph has " + std::to_string(num_nodes) +
+                                  " rows, but the index has " + std::to_string(_cur_num_nodes) + " nodes.");
+    }
+    int degree = add_reverse_edges ? forwardDegree() : static_cast<int>(_M);
+    std::vector<std::vector<dist_node_t>> node_links(num_nodes);
+
+    parallelFor(0, num_nodes, [&](uint64_t row) {
+      node_id_t node_id = row;
+      const neighbor_t* row_neighbors = neighbors + row * k;
+      PriorityQueue candidates;
+      std::vector<node_id_t> seen;
+      seen.reserve(k);
+      for (size_t j = 0; j < k && (prune || seen.size() < static_cast<size_t>(degree)); j++) {
+        int64_t neighbor = static_cast<int64_t>(row_neighbors[j]);
+        if (neighbor < 0 || static_cast<uint64_t>(neighbor) >= num_nodes || neighbor == node_id ||
+            std::find(seen.begin(), seen.end(), static_cast<node_id_t>(neighbor)) != seen.end()) {
+          continue;
+        }
+        seen.push_back(neighbor);
+        candidates.emplace(_distance->distance(/* x = */ getNodeData(node_id), /* y = */ getNodeData(neighbor)),
+                           neighbor);
+      }
+      if (prune) {
+        selectNeighbors(/* neighbors = */ candidates, /* M = */ degree);
+      }
+      node_links[row].reserve(candidates.size());
+      while (!candidates.empty()) {
+        node_links[row].push_back(candidates.top());
+        candidates.pop();
+      }
+    });
+
+    writeBatchLinks(/* first_node_id = */ 0, /* batch_links = */ node_links);
+    if (add_reverse_edges) {
+      addReverseEdges(/* first_node_id = */ 0, /* batch_links = */ node_links);
+    }
+  }
+
+  /**
+   * @brief Same as above, reading the kNN graph from a 2D .npy file of 32 or
+   * 64-bit integers.
+   *
+   * @exception std::runtime_error Thrown if the file cannot be read or holds
+   * another data type.
+   */
+  void importKnnGraph(const std::string& npy_filename, bool prune = true, bool add_reverse_edges = true) {
+    util::NpyMatrix matrix = util::loadNpyMatrix(npy_filename);
+    if (matrix.descr == "<i4") {
+      importKnnGraph(matrix.as<int32_t>(), matrix.rows, matrix.cols, prune, add_reverse_edges);
+    } else if (matrix.descr == "<u4") {
+      importKnnGraph(matrix.as<uint32_t>(), matrix.rows, matrix.cols, prune, add_reverse_edges);
+    } else if (matrix.descr == "<i8") {
+      importKnnGraph(matrix.as<int64_t>(), matrix.rows, matrix.cols, prune, add_reverse_edges);
+    } else if (matrix.descr == "<u8") {
+      importKnnGraph(matrix.as<uint64_t>(), matrix.rows, matrix.cols, prune, add_reverse_edges);
+    } else {
+      throw std::runtime_error("Unsupported kNN graph data type `" + matrix.descr + "` in " + npy_filename +
+                               ". Expected 32 or 64-bit integers.");
+    }
+  }
+
+  std::vector<std::vector<node_id_t>> getGraphOutdegreeTable() {
+    std::vector<std::vector<node_id_t>> outdegree_table(_cur_num_nodes);
     for (node_id_t node = 0; node < _cur_num_nodes; node++) {
       node_id_t* links = getNodeLinks(node);
-      for (int i = 0; i < _M; i++) {
+      for (size_t i = 0; i < _M; i++) {
         if (links[i] != node) {
           outdegree_table[node].push_back(links[i]);
         }
@@ -286,29 +465,178 @@ class Index {
   }
 
   /**
-   * @brief Store the new node in the global data structure. In a
-   * multi-threaded setting, the index data guard should be held by the caller
-   * with an exclusive lock.
+   * @brief Returns the graph in CSR form (see `util::CsrGraph`), without
+   * self-loops. It is built in parallel in two passes over the links, and
+   * uses two allocations instead of one per node.
+   */
+  util::CsrGraph<node_id_t> getGraphCsr() {
+    size_t num_nodes = _cur_num_nodes;
+    util::CsrGraph<node_id_t> graph;
+    graph.offsets.assign(num_nodes + 1, 0);
+    parallelFor(0, num_nodes, [&](uint64_t node) {
+      node_id_t* links = getNodeLinks(node);
+      graph.offsets[node + 1] = std::count_if(links, links + _M, [&](node_id_t link) { return link != node; });
+    });
+    for (size_t node = 0; node < num_nodes; node++) {
+      graph.offsets[node + 1] += graph.offsets[node];
+    }
+    graph.targets.resize(graph.offsets.back());
+    parallelFor(0, num_nodes, [&](uint64_t node) {
+      node_id_t* links = getNodeLinks(node);
+      std::copy_if(links, links + _M, graph.targets.begin() + graph.offsets[node],
+                   [&](node_id_t link) { return link != node; });
+    });
+    return graph;
+  }
+
+  /**
+   * @brief Computes degree histograms, unused link slots, strongly connected
+   * components, reachability and hubness of the graph (see
+   * `util::GraphStats`), using the index's threads.
+   *
+   * Reachability is measured from the nodes the entry policy starts searches
+   * from with `num_initializations` initializations (see `entryNodes`).
+   */
+  util::GraphStats graphStats(int num_initializations = 100) {
+    if (num_initializations <= 0) {
+      throw std::invalid_argument("num_initializations must be greater than 0.");
+    }
+    return util::graphStats(getGraphCsr(), _M, entryNodes(num_initializations), _num_threads);
+  }
+
+  /**
+   * @brief Adds links into the nodes that a search cannot reach from the entry
+   * points, or that have fewer than `min_in_degree` in-links. Back-edges that
+   * the pruning heuristic removed during construction leave such nodes behind,
+   * and no ef_search can find them.
+   *
+   * Every node to repair is searched for with its own vector. The closest
+   * nodes found, which are reachable, link to it. Nodes with a free slot are
+   * preferred; the others take the edge with their links pruned by the
+   * heuristic, as for back-edges.
+   * Pruning can drop the repair edge or another node's last in-link, so the
+   * graph is checked again after each round, and a node the heuristic keeps
+   * rejecting is linked from the next closest nodes in the next round.
+   *
+   * @param ef_search The search beam width used to find the new in-neighbors.
+   * @param min_in_degree Nodes with fewer in-links are repaired.
+   * @param num_initializations Number of entry points, as in `search`.
+   * @param max_rounds Maximum number of rounds of checks and repairs.
+   * @return The number of repair edges that were kept.
+   */
+  size_t repairConnectivity(int ef_search = 100, size_t min_in_degree = 1, int num_initializations = 100,
+                            size_t max_rounds = 4) {
+    if (num_initializations <= 0) {
+      throw std::invalid_argument("num_initializations must be greater than 0.");
+    }
+    size_t num_repaired_edges = 0;
+    if (_cur_num_nodes < 2) {
+      return num_repaired_edges;
+    }
+    std::vector<node_id_t> entry_nodes = entryNodes(num_initializations);
+
+    for (size_t round = 0; round < max_rounds; round++) {
+      util::CsrGraph<node_id_t> graph = getGraphCsr();
+      std::vector<uint32_t> in_degrees = util::inDegrees(graph, _num_threads);
+      std::vector<uint8_t> reached = util::reachableNodes(graph, entry_nodes, _num_threads);
+      std::vector<node_id_t> targets;
+      for (size_t node = 0; node < graph.numNodes(); node++) {
+        if (!reached[node] || in_degrees[node] < min_in_degree) {
+          targets.push_back(node);
+        }
+      }
+      if (targets.empty()) {
+        break;
+      }
+
+      // Up to `num_sources` sources per target, skipping the sources that
+      // earlier rounds tried.
+      std::vector<std::vector<std::pair<node_id_t, dist_node_t>>> target_edges(targets.size());
+      parallelFor(0, targets.size(), [&](uint64_t i) {
+        node_id_t target = targets[i];
+        size_t num_sources = std::max<size_t>(min_in_degree, in_degrees[target] + 1) - in_degrees[target];
+        size_t num_skipped = round * num_sources;
+        std::vector<float> query_buffer;
+        const void* query = getNodeQuery(target, query_buffer);
+        PriorityQueue neighbors = beamSearch(/* query = */ query,
+                                             /* entry_node = */ initializeSearch(query, num_initializations),
+                                             /* buffer_size = */ std::max<int>(ef_search, num_skipped + num_sources + 1));
+        std::vector<dist_node_t> closest;
+        while (!neighbors.empty()) {
+          if (neighbors.top().second != target) {
+            closest.push_back(neighbors.top());
+          }
+          neighbors.pop();
+        }
+        // Closest first, but nodes with a free slot take the edge without
+        // pruning, so they go before the nodes with full link lists.
+        std::reverse(closest.begin(), closest.end());
+        std::stable_partition(closest.begin(), closest.end(), [&](const dist_node_t& candidate) {
+          return getNodeLinks(candidate.second)[_M - 1] == candidate.second;
+        });
+        size_t num_candidates = 0;
+        for (const auto& [_, source] : closest) {
+          node_id_t* links = getNodeLinks(source);
+          if (std::find(links, links + _M, target) != links + _M || num_candidates++ < num_skipped) {
+            continue;
+          }
+          float distance = _distance->distance(/* x = */ getNodeData(source), /* y = */ getNodeData(target));
+          target_edges[i].push_back({source, {distance, target}});
+          if (target_edges[i].size() == num_sources) {
+            break;
+          }
+        }
+      });
+
+      // (source, (distance, target)) pairs grouped by source, so that every
+      // source is modified by exactly one thread.
+      std::vector<std::pair<node_id_t, dist_node_t>> edges;
+      for (const auto& edges_of_target : target_edges) {
+        edges.insert(edges.end(), edges_of_target.begin(), edges_of_target.end());
+      }
+      target_edges.clear();
+      std::sort(edges.begin(), edges.end());
+      std::vector<size_t> group_offsets;
+      for (size_t i = 0; i < edges.size(); i++) {
+        if (i == 0 || edges[i].first != edges[i - 1].first) {
+          group_offsets.push_back(i);
+        }
+      }
+      group_offsets.push_back(edges.size());
+
+      std::atomic<size_t> num_kept(0);
+      parallelFor(0, group_offsets.size() - 1, [&](uint64_t group) {
+        node_id_t source = edges[group_offsets[group]].first;
+        std::vector<dist_node_t> new_links;
+        for (size_t i = group_offsets[group]; i < group_offsets[group + 1]; i++) {
+          new_links.push_back(edges[i].second);
+        }
+        mergeNodeLinks(/* node_id = */ source, /* new_links = */ new_links);
+        node_id_t* links = getNodeLinks(source);
+        for (const auto& [_, target] : new_links) {
+          num_kept += std::find(links, links + _M, target) != links + _M;
+        }
+      });
+      num_repaired_edges += num_kept;
+    }
+    return num_repaired_edges;
+  }
+
+  /**
+   * @brief Store the new node in the global data structure, without linking
+   * it into the graph. This is safe to call from multiple threads.
    *
    * @param data The vector to add.
    * @param label The label (meta-data) of the vector.
    * @param new_node_id The id of the new node.
+   *
+   * @exception std::runtime_error Thrown if the maximum number of nodes is
+   * reached.
    */
   void allocateNode(void* data, label_t& label, node_id_t& new_node_id) {
-    new_node_id = _cur_num_nodes;
-    _distance->transformData(
-        /* destination = */ getNodeData(new_node_id),
-        /* src = */ data);
-    *(getNodeLabel(new_node_id)) = label;
-    node_id_t* links = getNodeLinks(new_node_id);
-    // Initialize all edges to self
-    std::fill_n(links, _M, new_node_id);
-    _cur_num_nodes++;
-
-    // Initialize top frequency tree.
-    if (_top_node_frequencies.size() < _num_top_nodes) {
-      _top_node_frequencies.insert(new_node_id);
-    }
+    new_node_id = reserveNode();
+    initializeNode(data, label, new_node_id);
+    publishNode(new_node_id);
   }
 
   /**
@@ -343,13 +671,13 @@ class Index {
       if (num_initializations <= 0) {
           throw std::invalid_argument("num_initializations must be greater than 0.");
       }
-      uint32_t total_num_nodes = labels.size();
-      uint32_t data_dimension = _distance->dimension();
+      uint64_t total_num_nodes = labels.size();
+      uint64_t data_dimension = _distance->dimension();
 
       // Don't spawn any threads if we are only using one.
       if (_num_threads == 1) {
-          for (uint32_t row_index = 0; row_index < total_num_nodes; row_index++) {
-              uint64_t offset = static_cast<uint64_t>(row_index) * static_cast<uint64_t>(data_dimension);
+          for (uint64_t row_index = 0; row_index < total_num_nodes; row_index++) {
+              uint64_t offset = row_index * data_dimension;
               void* vector = (data_type*)data + offset;
               label_t label = labels[row_index];
               this->add(vector, label, ef_construction, num_initializations);
@@ -360,14 +688,112 @@ class Index {
       flatnav::executeInParallel(
           /* start_index = */ 0, /* end_index = */ total_num_nodes,
           /* num_threads = */ _num_threads, /* function = */
-          [&](uint32_t row_index) {
-              uint64_t offset = static_cast<uint64_t>(row_index) * static_cast<uint64_t>(data_dimension);
+          [&](uint64_t row_index) {
+              uint64_t offset = row_index * data_dimension;
               void* vector = (data_type*)data + offset;
               label_t label = labels[row_index];
               this->add(vector, label, ef_construction, num_initializations);
           });
   }
 
+  /**
+   * @brief Adds vectors to the index with a batch-parallel builder.
+   *
+   * Unlike `addBatch`, which links every vector as soon as it is inserted,
+   * this method links whole batches of nodes in two phases. In the search
+   * phase, the neighbors of every node in the batch are found with parallel
+   * beam searches over a frozen snapshot of the graph. In the commit phase,
+   * the forward links are written and the reverse edges are grouped by target,
+   * so the links of any node are only modified by one thread and no locking is
+   * needed. Batch sizes follow the size of the graph (prefix doubling), capped
+   * at 2% of the vectors being added.
+   *
+   * Every additional pass re-links all nodes of the index in the same way,
+   * this time against the complete graph. This mostly helps the nodes that
+   * were linked while the graph was still small.
+   *
+   * The resulting graph has the same format as the one built by `addBatch`.
+   * This method must not run concurrently with other modifications of the
+   * index.
+   *
+   * @param data Pointer to the array of vectors to be added.
+   * @param labels A vector of labels corresponding to each vector in `data`.
+   * @param ef_construction Parameter for controlling the size of the dynamic
+   * candidate list during the construction of the graph.
+   * @param num_initializations Number of initializations for the search
+   * algorithm. Must be greater than 0.
+   * @param num_passes Number of passes over the graph. Must be greater than 0.
+   *
+   * @exception std::invalid_argument Thrown if `num_initializations` or
+   * `num_passes` is less than or equal to 0.
+   * @exception std::runtime_error Thrown if the index does not have room for
+   * all the vectors.
+   */
+  template <typename data_type>
+  void addBulk(void* data, std::vector<label_t>& labels, int ef_construction, int num_initializations = 100,
+               int num_passes = 1) {
+    if (num_initializations <= 0) {
+      throw std::invalid_argument("num_initializations must be greater than 0.");
+    }
+    if (num_passes <= 0) {
+      throw std::invalid_argument("num_passes must be greater than 0.");
+    }
+    uint64_t total_num_nodes = labels.size();
+    uint64_t data_dimension = _distance->dimension();
+    if (_num_reserved_nodes + total_num_nodes > _max_node_count) {
+      throw std::runtime_error(
+          "Maximum number of nodes reached. Consider "
+          "increasing the `max_node_count` parameter to "
+          "create a larger index.");
+    }
+
+    size_t max_batch_size = std::max<size_t>(total_num_nodes / 50, 1);
+    uint64_t row_index = 0;
+    while (row_index < total_num_nodes) {
+      size_t batch_size = std::min<size_t>(
+          {std::max<size_t>(_cur_num_nodes, 1), max_batch_size, total_num_nodes - row_index});
+      node_id_t first_node_id = _cur_num_nodes;
+
+      // The new nodes are written but not published, so that searches for
+      // this batch only see the graph as it was before the batch.
+      std::vector<const void*> queries(batch_size);
+      for (size_t i = 0; i < batch_size; i++) {
+        queries[i] = (data_type*)data + (row_index + i) * data_dimension;
+        node_id_t node_id = reserveNode();
+        initializeNode(const_cast<void*>(queries[i]), labels[row_index + i], node_id);
+      }
+      if (first_node_id > 0) {
+        auto batch_links = searchBatchNeighbors(
+            /* queries = */ queries, /* first_node_id = */ first_node_id,
+            /* ef_construction = */ ef_construction,
+            /* num_initializations = */ num_initializations, /* relink = */ false);
+        commitBatchLinks(/* first_node_id = */ first_node_id, /* batch_links = */ batch_links);
+      }
+      for (size_t i = 0; i < batch_size; i++) {
+        publishNode(first_node_id + i);
+      }
+      row_index += batch_size;
+    }
+
+    for (int pass = 1; pass < num_passes; pass++) {
+      size_t num_nodes = _cur_num_nodes;
+      size_t relink_batch_size = std::max<size_t>(num_nodes / 50, 1);
+      for (size_t first_node_id = 0; first_node_id < num_nodes; first_node_id += relink_batch_size) {
+        size_t batch_size = std::min(relink_batch_size, num_nodes - first_node_id);
+        std::vector<const void*> queries(batch_size);
+        std::vector<std::vector<float>> query_buffers(batch_size);
+        for (size_t i = 0; i < batch_size; i++) {
+          queries[i] = getNodeQuery(first_node_id + i, query_buffers[i]);
+        }
+        auto batch_links = searchBatchNeighbors(
+            /* queries = */ queries, /* first_node_id = */ first_node_id,
+            /* ef_construction = */ ef_construction,
+            /* num_initializations = */ num_initializations, /* relink = */ true);
+        commitBatchLinks(/* first_node_id = */ first_node_id, /* batch_links = */ batch_links);
+      }
+    }
+  }
+
   /**
    * @brief Adds a single vector to the index.
    *
@@ -375,48 +801,193 @@ class Index {
    * batch. The method ensures thread safety by using locking primitives,
    * allowing it to be safely used in a multi-threaded environment.
    *
-   * The method first checks if the current number of nodes has reached the
-   * maximum capacity. If so, it throws a runtime error. It then locks the index
-   * structure to prevent concurrent modifications while allocating a new node.
-   * After unlocking, it connects the new node to its neighbors in the graph.
+   * The method first reserves a node id with an atomic counter, which throws a
+   * runtime error if the index is full, and writes the new node into its slot.
+   * The entry point is then selected among the nodes that are already
+   * published, without holding any global lock. The new node is published once
+   * all nodes with smaller ids are, and it is finally connected to its
+   * neighbors in the graph.
    *
    * @param data Pointer to the vector data being added.
    * @param label Label associated with the vector.
    * @param ef_construction Parameter controlling the size of the dynamic
    * candidate list during the construction of the graph.
    * @param num_initializations Number of initializations for the search
-   * algorithm.
+   * algorithm. Must be greater than 0.
    *
+   * @exception std::invalid_argument Thrown if `num_initializations` is less
+   * than or equal to 0.
    * @exception std::runtime_error Thrown if the maximum number of nodes is
    * reached.
    */
   void add(void* data, label_t& label, int ef_construction, int num_initializations) {
-
-    if (_cur_num_nodes >= _max_node_count) {
-      throw std::runtime_error(
-          "Maximum number of nodes reached. Consider "
-          "increasing the `max_node_count` parameter to "
-          "create a larger index.");
+    if (num_initializations <= 0) {
+      throw std::invalid_argument("num_initializations must be greater than 0.");
     }
-    std::unique_lock<std::mutex> global_lock(_index_data_guard);
-    auto entry_node = initializeSearch(data, num_initializations);
-    node_id_t new_node_id;
-    allocateNode(data, label, new_node_id);
-    global_lock.unlock();
+    node_id_t new_node_id = reserveNode();
 
-    if (new_node_id == 0) {
-      return;
+    // Later inserts wait for this node to be published, so it is published
+    // even if it fails before then.
+    std::vector<char> query_buffer;
+    const void* query = nullptr;
+    node_id_t entry_node = 0;
+    try {
+      initializeNode(data, label, new_node_id);
+      if (new_node_id == 0) {
+        publishNode(new_node_id);
+        return;
+      }
+
+      // Entry point selection needs at least one published node. Only the
+      // first few inserts of a parallel build can get here before node 0 is.
+      while (_cur_num_nodes.load(std::memory_order_acquire) == 0) {
+        std::this_thread::yield();
+      }
+      query = _distance->transformQuery(data, query_buffer);
+      entry_node = initializeSearch(query, num_initializations);
+    } catch (...) {
+      publishNode(new_node_id);
+      throw;
     }
+    publishNode(new_node_id);
 
     auto neighbors = beamSearch(
-        /* query = */ data, /* entry_node = */ entry_node,
+        /* query = */ query, /* entry_node = */ entry_node,
         /* buffer_size = */ ef_construction);
 
-    int selection_M = std::max(static_cast<int>(_M / 2), 1);
-    selectNeighbors(/* neighbors = */ neighbors, /* M = */ selection_M);
+    selectNeighbors(/* neighbors = */ neighbors, /* M = */ forwardDegree());
     connectNeighbors(neighbors, new_node_id);
   }
 
+  /**
+   * @brief Updates vectors in the index in batches.
+   *
+   * This is the counterpart of `addBatch` for labels that are already in the
+   * index. Each row of `data` replaces the vector stored under the label at the
+   * same position in `labels`.
+   *
+   * @param data Pointer to the array of new vectors.
+   * @param labels A vector of labels corresponding to each vector in `data`.
+   * @param ef_construction Parameter for controlling the size of the dynamic
+   * candidate list while re-linking the updated nodes.
+   * @param num_initializations Number of initializations for the search
+   * algorithm. Must be greater than 0.
+   *
+   * @exception std::invalid_argument Thrown if a label is not in the index.
+   */
+  template <typename data_type>
+  void updateBatch(void* data, std::vector<label_t>& labels, int ef_construction,
+                   int num_initializations = 100) {
+    if (num_initializations <= 0) {
+      throw std::invalid_argument("num_initializations must be greater than 0.");
+    }
+    uint64_t total_num_nodes = labels.size();
+    uint64_t data_dimension = _distance->dimension();
+
+    if (_num_threads == 1) {
+      for (uint64_t row_index = 0; row_index < total_num_nodes; row_index++) {
+        uint64_t offset = row_index * data_dimension;
+        void* vector = (data_type*)data + offset;
+        this->update(vector, labels[row_index], ef_construction, num_initializations);
+      }
+      return;
+    }
+
+    flatnav::executeInParallel(
+        /* start_index = */ 0, /* end_index = */ total_num_nodes,
+        /* num_threads = */ _num_threads, /* function = */
+        [&](uint64_t row_index) {
+          uint64_t offset = row_index * data_dimension;
+          void* vector = (data_type*)data + offset;
+          this->update(vector, labels[row_index], ef_construction, num_initializations);
+        });
+  }
+
+  /**
+   * @brief Replaces the vector stored under `label` and re-links its node.
+   *
+   * The node keeps its id and its label. Its data is overwritten through
+   * `transformData`, its outgoing links are re-selected from a beam search
+   * around the new vector, and back-edges are added to the new neighbors
+   * exactly as in `add`. Former neighbors that still point to the node and have
+   * no free slot are re-pruned, since the distance to the node has changed.
+   * The cost is roughly that of a single insertion.
+   *
+   * @param data Pointer to the new vector.
+   * @param label Label of the vector to update.
+   * @param ef_construction Parameter controlling the size of the dynamic
+   * candidate list while re-linking the node.
+   * @param num_initializations Number of initializations for the search
+   * algorithm.
+   *
+   * @exception std::invalid_argument Thrown if the label is not in the index.
+   */
+  void update(void* data, const label_t& label, int ef_construction, int num_initializations = 100) {
+    std::optional<node_id_t> found = findNode(label);
+    if (!found) {
+      throw std::invalid_argument("Cannot update a label that is not in the index.");
+    }
+    node_id_t node_id = *found;
+
+    std::vector<node_id_t> old_neighbors;
+    old_neighbors.reserve(_M);
+    {
+      std::unique_lock<std::mutex> lock(_node_links_mutexes[node_id]);
+      _distance->transformData(
+          /* destination = */ getNodeData(node_id),
+          /* src = */ data);
+
+      node_id_t* links = getNodeLinks(node_id);
+      for (size_t i = 0; i < _M; i++) {
+        if (links[i] != node_id) {
+          old_neighbors.push_back(links[i]);
+        }
+      }
+      std::fill_n(links, _M, node_id);
+    }
+
+    if (_cur_num_nodes == 1) {
+      return;
+    }
+
+    std::vector<char> query_buffer;
+    const void* query = _distance->transformQuery(data, query_buffer);
+    auto entry_node = initializeSearch(query, num_initializations);
+    PriorityQueue candidates = beamSearch(
+        /* query = */ query, /* entry_node = */ entry_node,
+        /* buffer_size = */ ef_construction);
+
+    // The node is still reachable in the graph, so the search will usually
+    // find it at distance zero. It must not become its own neighbor.
+    PriorityQueue neighbors;
+    while (!candidates.empty()) {
+      if (candidates.top().second != node_id) {
+        neighbors.push(candidates.top());
+      }
+      candidates.pop();
+    }
+
+    selectNeighbors(/* neighbors = */ neighbors, /* M = */ forwardDegree());
+    connectNeighbors(neighbors, node_id);
+
+    for (node_id_t neighbor_node_id : old_neighbors) {
+      std::unique_lock<std::mutex> lock(_node_links_mutexes[neighbor_node_id]);
+      node_id_t* neighbor_node_links = getNodeLinks(neighbor_node_id);
+      node_id_t* end = neighbor_node_links + _M;
+      node_id_t* link_to_node = std::find(neighbor_node_links, end, node_id);
+      bool has_free_slot = std::find(neighbor_node_links, end, neighbor_node_id) != end;
+      if (link_to_node == end) {
+        continue;
+      }
+      if (!has_free_slot) {
+        pruneNodeLinks(/* node_id = */ neighbor_node_id, /* candidate_id = */ node_id);
+      } else if (_link_distances) {
+        getLinkDistances(neighbor_node_id)[link_to_node - neighbor_node_links] =
+            _distance->distance(/* x = */ getNodeData(neighbor_node_id), /* y = */ getNodeData(node_id));
+      }
+    }
+  }
+
   /***
    * @brief Search the index for the k nearest neighbors of the query.
    * @param query The query vector.
@@ -426,6 +997,8 @@ class Index {
    */
   std::vector<dist_label_t> search(const void* query, const int K, int ef_search,
                                    int num_initializations = 100) {
+    std::vector<char> query_buffer;
+    query = _distance->transformQuery(query, query_buffer);
     node_id_t entry_node = initializeSearch(query, num_initializations);
     PriorityQueue neighbors = beamSearch(/* query = */ query,
                                          /* entry_node = */ entry_node,
@@ -448,16 +1021,152 @@ class Index {
     return results;
   }
 
+  /**
+   * @brief Caches the distance from every node to each of its links, so that
+   * pruning a full link list during construction does not recompute the M
+   * distances to the existing links. The cache costs M floats per node of the
+   * index capacity and is filled for the links that already exist. It is kept
+   * up to date by construction, updates and graph re-ordering, and it is not
+   * serialized.
+   *
+   * After `update`, cached distances from nodes that link to the updated node
+   * but were not among its neighbors are stale until those nodes are pruned
+   * again. This only affects which links pruning keeps.
+   */
+  void enableLinkDistances() {
+    if (_link_distances) {
+      return;
+    }
+    _link_distances = std::make_unique<float[]>(_max_node_count * _M);
+    for (node_id_t node = 0; node < _cur_num_nodes; node++) {
+      node_id_t* links = getNodeLinks(node);
+      float* distances = getLinkDistances(node);
+      for (size_t i = 0; i < _M; i++) {
+        distances[i] = links[i] == node
+                           ? 0.0f
+                           : _distance->distance(/* x = */ getNodeData(node), /* y = */ getNodeData(links[i]));
+      }
+    }
+  }
+
+  /**
+   * @brief Frees the link distance cache, e.g. once the index is final and
+   * will only be searched.
+   */
+  void dropLinkDistances() { _link_distances.reset(); }
+
+  inline bool linkDistancesEnabled() const { return _link_distances != nullptr; }
+
+  /**
+   * @brief Builds a label -> node id map over the nodes currently in the index
+   * and keeps it up to date in `allocateNode` and graph re-ordering. Without
+   * it, label lookups (`contains`, `getVector`, `searchByLabel`, `update`) fall
+   * back to a linear scan. The map costs roughly 8-16 bytes per node of the
+   * index capacity and is not serialized with the index. Lookups may overlap
+   * with inserts, but enabling the map and re-ordering may not.
+   *
+   * A label added more than once refers to the node with the largest id, with
+   * or without the map. That is the latest insert until the graph is re-ordered.
+   */
+  void enableLabelLookup() {
+    _label_map = std::make_unique<LabelMap<label_t, node_id_t>>(_max_node_count);
+    for (node_id_t node = 0; node < _cur_num_nodes; node++) {
+      _label_map->insert(*getNodeLabel(node), node,
+                         [this](node_id_t n) -> const label_t& { return *getNodeLabel(n); });
+    }
+  }
+
+  inline bool labelLookupEnabled() const { return _label_map != nullptr; }
+
+  /**
+   * @brief Returns true if a vector with the given label is in the index.
+   */
+  bool contains(const label_t& label) const { return findNode(label).has_value(); }
+
+  /**
+   * @brief Returns a pointer to the stored representation of the vector with
+   * the given label. This is the output of the distance's `transformData`, and
+   * it has `dataSizeBytes()` bytes. The pointer is invalidated by graph
+   * re-ordering.
+   *
+   * @exception std::invalid_argument Thrown if the label is not in the index.
+   */
+  const void* getVector(const label_t& label) const {
+    std::optional<node_id_t> node_id = findNode(label);
+    if (!node_id) {
+      throw std::invalid_argument("Label not found in the index.");
+    }
+    return getNodeData(*node_id);
+  }
+
+  /***
+   * @brief Search the index for the k nearest neighbors of a vector that is
+   * already in the index ("more like this item").
+   *
+   * The stored vector is used as the query and its node as the entry point, so
+   * neither the query vector nor an entry point search is needed. The item
+   * itself is excluded from the results. The stored vector is the query, decoded
+   * to float32 for 16-bit float data. Other distances must store vectors in a
+   * form that is a valid query, which holds when `transformData` is a copy.
+   *
+   * @param label The label of the item to search around.
+   * @param K The number of nearest neighbors to return.
+   * @param ef_search The search beam width.
+   *
+   * @exception std::invalid_argument Thrown if the label is not in the index.
+   */
+  std::vector<dist_label_t> searchByLabel(const label_t& label, const int K, int ef_search) {
+    std::optional<node_id_t> found = findNode(label);
+    if (!found) {
+      throw std::invalid_argument("Label not found in the index.");
+    }
+    node_id_t node_id = *found;
+
+    std::vector<float> query_buffer;
+    PriorityQueue neighbors = beamSearch(/* query = */ getNodeQuery(node_id, query_buffer),
+                                         /* entry_node = */ node_id,
+                                         /* buffer_size = */ std::max(ef_search, K + 1));
+    std::vector<dist_label_t> results;
+    results.reserve(neighbors.size());
+    while (!neighbors.empty()) {
+      auto [distance, neighbor_id] = neighbors.top();
+      if (neighbor_id != node_id) {
+        results.emplace_back(distance, *getNodeLabel(neighbor_id));
+      }
+      neighbors.pop();
+    }
+    std::sort(results.begin(), results.end(),
+              [](const dist_label_t& left, const dist_label_t& right) { return left.first < right.first; });
+    if (results.size() > static_cast<size_t>(K)) {
+      results.resize(K);
+    }
+
+    return results;
+  }
+
 
   void doGraphReordering(const std::vector<std::string>& reordering_methods) {
 
     for (const auto& method : reordering_methods) {
-      auto outdegree_table = getGraphOutdegreeTable();
+      // The vector-space orderings do not need the outdegree table.
+      if (method == "zorder") {
+        reorderZOrder();
+        continue;
+      } else if (method == "kmeans") {
+        reorderKMeans();
+        continue;
+      }
+
+      auto graph = getGraphCsr();
       std::vector<node_id_t> P;
       if (method == "gorder") {
-        P = std::move(util::gOrder<node_id_t>(outdegree_table, 5));
+        P = std::move(util::gOrder<node_id_t>(graph, 5));
+      } else if (method == "pgorder") {
+        P = std::move(util::parallelGOrder<node_id_t>(graph, 5, _num_threads, _num_threads));
       } else if (method == "rcm") {
-        P = std::move(util::rcmOrder<node_id_t>(outdegree_table));
+        P = std::move(util::rcmOrder<node_id_t>(graph, _num_threads));
+      } else if (method == "frequency") {
+        P = std::move(util::hubOrder<node_id_t>(graph, _node_frequencies));
       } else {
         throw std::invalid_argument("Invalid reordering method: " + method);
       }
@@ -467,19 +1176,88 @@ class Index {
   }
 
   void reorderGOrder(const int window_size = 5) {
-    auto outdegree_table = getGraphOutdegreeTable();
-    std::vector<node_id_t> P = util::gOrder<node_id_t>(outdegree_table, window_size);
+    auto graph = getGraphCsr();
+    std::vector<node_id_t> P = util::gOrder<node_id_t>(graph, window_size);
+
+    relabel(P);
+  }
+
+  /**
+   * @brief Gorder run concurrently on `num_partitions` BFS partitions of the
+   * graph (see `util::parallelGOrder`). 0 uses one partition per thread.
+   */
+  void reorderParallelGOrder(const int window_size = 5, size_t num_partitions = 0) {
+    auto graph = getGraphCsr();
+    std::vector<node_id_t> P = util::parallelGOrder<node_id_t>(
+        graph, window_size, num_partitions ? num_partitions : _num_threads, _num_threads);
+    relabel(P);
+  }
+
+  /**
+   * @brief Packs the nodes visited most by past searches, and their visited
+   * neighbors up to `depth` hops away, at the front of the index (see
+   * `util::hubOrder`). Run it after serving a representative query workload;
+   * visit counts are not saved with the index.
+   */
+  void reorderByFrequency(const int depth = 1) {
+    auto graph = getGraphCsr();
+    std::vector<node_id_t> P = util::hubOrder<node_id_t>(graph, _node_frequencies, depth);
+    relabel(P);
+  }
+
+  /**
+   * @brief Orders nodes by the Z-order key of their vectors projected onto a
+   * few random directions (see `util::zOrder`). This only reads the vectors,
+   * so it is much cheaper than Gorder and does not build the outdegree table.
+   *
+   * @exception std::invalid_argument Thrown if the stored vectors are not
+   * float32, float16, bfloat16, int8 or uint8 arrays (e.g. quantized codes).
+   */
+  void reorderZOrder(int num_projections = 8) {
+    checkVectorsReadable();
+    std::vector<node_id_t> P = util::zOrder<node_id_t>(
+        _cur_num_nodes, _distance->dimension(),
+        [this](node_id_t node, float* destination) { readNodeVector(node, destination); }, _num_threads,
+        num_projections);
+    relabel(P);
+  }
 
+  /**
+   * @brief Groups nodes by k-means cluster of their vectors, with clusters in
+   * the Z-order of their centroids (see `util::kmeansOrder`). 0 clusters
+   * selects sqrt(number of nodes).
+   *
+   * @exception std::invalid_argument Thrown if the stored vectors are not
+   * float32, float16, bfloat16, int8 or uint8 arrays (e.g. quantized codes).
+   */
+  void reorderKMeans(size_t num_clusters = 0, int num_iterations = 10) {
+    checkVectorsReadable();
+    std::vector<node_id_t> P = util::kmeansOrder<node_id_t>(
+        _cur_num_nodes, _distance->dimension(),
+        [this](node_id_t node, float* destination) { readNodeVector(node, destination); }, _num_threads,
+        num_clusters, num_iterations);
     relabel(P);
   }
 
   void reorderRCM() {
-    auto outdegree_table = getGraphOutdegreeTable();
-    std::vector<node_id_t> P = util::rcmOrder<node_id_t>(outdegree_table);
+    auto graph = getGraphCsr();
+    std::vector<node_id_t> P = util::rcmOrder<node_id_t>(graph, _num_threads);
     relabel(P);
   }
 
-  static std::unique_ptr<Index<dist_t, label_t>> loadIndex(const std::string& filename) {
+  // True if the nodes were reordered since the index was built, possibly
+  // before it was saved.
+  inline bool isReordered() const { return !_permutation.empty(); }
+
+  /**
+   * @brief Returns the composition of every reordering applied to the index:
+   * the node with id i when it was inserted now has id permutation()[i]. Nodes
+   * added after the last reordering keep their ids and may be missing. Empty
+   * if the index was never reordered.
+   */
+  inline const std::vector<node_id_t>& permutation() const { return _permutation; }
+
+  static std::unique_ptr<Index<dist_t, label_t, node_id_t>> loadIndex(const std::string& filename) {
     std::ifstream stream(filename, std::ios::binary);
 
     if (!stream.is_open()) {
@@ -487,25 +1265,45 @@ class Index {
     }
 
     cereal::BinaryInputArchive archive(stream);
-    std::unique_ptr<Index<dist_t, label_t>> index(new Index<dist_t, label_t>());
+    std::unique_ptr<Index<dist_t, label_t, node_id_t>> index(new Index<dist_t, label_t, node_id_t>());
 
     std::unique_ptr<DistanceInterface<dist_t>> dist = std::make_unique<dist_t>();
 
     // 1. Deserialize metadata
+    size_t cur_num_nodes;
     archive(index->_data_type, 
             index->_M, 
             index->_data_size_bytes, 
             index->_node_size_bytes, 
             index->_max_node_count,
-            index->_cur_num_nodes, 
+            cur_num_nodes, 
             *dist
     );
-    index->_visited_set_pool = new VisitedSetPool(
+    index->_cur_num_nodes = cur_num_nodes;
+    index->_num_reserved_nodes = cur_num_nodes;
+
+    // The node id and label widths are not stored explicitly, but they are
+    // part of the node layout. Refuse to read links with the wrong width.
+    size_t expected_node_size_bytes =
+        index->_data_size_bytes + (index->_M * sizeof(node_id_t)) + sizeof(label_t);
+    if (index->_node_size_bytes != expected_node_size_bytes) {
+      throw std::runtime_error(
+          "Node size in " + filename + " does not match this index type. The index was "
+          "likely saved with a different node id or label type.");
+    }
+    if (index->_max_node_count > static_cast<size_t>(std::numeric_limits<node_id_t>::max())) {
+      throw std::runtime_error("Index in " + filename + " has too many nodes for node_id_t.");
+    }
+
+    index->_visited_set_pool = new VisitedSetPool<node_id_t>(
         /* initial_pool_size = */ 1,
         /* num_elements = */ index->_max_node_count);
     index->_distance = std::move(dist);
     index->_num_threads = std::max((uint32_t)1, (uint32_t)std::thread::hardware_concurrency() / 2);
     index->_node_links_mutexes = std::vector<std::mutex>(index->_max_node_count);
+    index->_node_frequencies = std::vector<uint32_t>(index->_max_node_count);
+    index->_top_node_frequencies =
+        std::multiset<node_id_t, CompareByFrequency>(CompareByFrequency(index->_node_frequencies));
 
     // 2. Allocate memory using deserialized metadata
     uint64_t mem_size = static_cast<uint64_t>(index->_node_size_bytes) * static_cast<uint64_t>(index->_max_node_count);
@@ -515,6 +1313,18 @@ class Index {
     // 3. Deserialize content into allocated memory
     archive(cereal::binary_data(index->_index_memory, mem_size));
 
+    // 4. Deserialize the reordering permutation, if the file has one
+    if (stream.peek() != std::ifstream::traits_type::eof()) {
+      uint64_t permutation_size;
+      archive(permutation_size);
+      index->_permutation.resize(permutation_size);
+      archive(cereal::binary_data(index->_permutation.data(), permutation_size * sizeof(node_id_t)));
+    }
+
+    for (node_id_t node = 0; node < index->_cur_num_nodes && node < _num_top_nodes; node++) {
+      index->_top_node_frequencies.insert(node);
+    }
+
     return index;
   }
 
@@ -551,7 +1361,15 @@ class Index {
 
   inline uint64_t visitedSetPoolAllocatedMemory() const {
     size_t pool_size = _visited_set_pool->poolSize();
-    return static_cast<uint64_t>(pool_size * sizeof(VisitedSet));
+    return static_cast<uint64_t>(pool_size * sizeof(VisitedSet<node_id_t>));
+  }
+
+  inline uint64_t linkDistancesAllocatedMemory() const {
+    return _link_distances ? static_cast<uint64_t>(_max_node_count * _M * sizeof(float)) : 0;
+  }
+
+  inline uint64_t labelMapAllocatedMemory() const {
+    return _label_map ? _label_map->allocatedMemory() : 0;
   }
 
   inline uint32_t getNumThreads() const { return _num_threads; }
@@ -570,6 +1388,8 @@ class Index {
 
   inline DataType getDataType() const { return _data_type; }
 
+  inline const PruningConfig& pruningConfig() const { return _pruning; }
+
   void resetStats() {
     _distance_computations = 0;
     _metric_hops = 0;
@@ -589,6 +1409,8 @@ class Index {
 
  private:
   friend class cereal::access;
+  template <typename, typename, typename>
+  friend class build::NNDescent;
   // Default constructor for cereal
   Index() = default;
 
@@ -597,6 +1419,56 @@ class Index {
     return _index_memory + byte_offset;
   }
 
+  // Decodes the vector stored at node n into `dimension` floats. The vector
+  // is read as stored, i.e. after the distance's transformData.
+  void readNodeVector(node_id_t n, float* destination) const {
+    size_t dimension = _distance->dimension();
+    const char* data = getNodeData(n);
+    switch (_distance->getDataType()) {
+      case DataType::float32:
+        std::memcpy(destination, data, dimension * sizeof(float));
+        break;
+      case DataType::int8:
+        std::copy(reinterpret_cast<const int8_t*>(data), reinterpret_cast<const int8_t*>(data) + dimension,
+                  destination);
+        break;
+      case DataType::uint8:
+        std::copy(reinterpret_cast<const uint8_t*>(data), reinterpret_cast<const uint8_t*>(data) + dimension,
+                  destination);
+        break;
+      case DataType::float16:
+        util::convertToFloat(reinterpret_cast<const util::float16_t*>(data), destination, dimension);
+        break;
+      case DataType::bfloat16:
+        util::convertToFloat(reinterpret_cast<const util::bfloat16_t*>(data), destination, dimension);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Vector-space reorderings decode the stored vectors with readNodeVector.
+  void checkVectorsReadable() const {
+    DataType data_type = _distance->getDataType();
+    bool supported = data_type == DataType::float32 || data_type == DataType::int8 ||
+                     data_type == DataType::uint8 || util::isHalfPrecision(data_type);
+    if (!supported || _data_size_bytes != _distance->dimension() * util::size(data_type)) {
+      throw std::invalid_argument("Vector-space reordering needs float32, float16, bfloat16, int8 or uint8 vectors.");
+    }
+  }
+
+  // The vector stored at node n, as a search query. Queries are given in the
+  // input representation, which for 16-bit float data is float32 and not the
+  // stored one, so such vectors are decoded into `buffer`.
+  const void* getNodeQuery(node_id_t n, std::vector<float>& buffer) const {
+    if (!util::isHalfPrecision(_distance->getDataType())) {
+      return getNodeData(n);
+    }
+    buffer.resize(_distance->dimension());
+    readNodeVector(n, buffer.data());
+    return buffer.data();
+  }
+
   node_id_t* getNodeLinks(const node_id_t& n) const {
     uint64_t byte_offset = static_cast<uint64_t>(n) * static_cast<uint64_t>(_node_size_bytes);
     byte_offset += _data_size_bytes;
@@ -612,8 +1484,15 @@ class Index {
     return reinterpret_cast<label_t*>(location);
   }
 
+  float* getLinkDistances(const node_id_t& n) const {
+    return _link_distances.get() + static_cast<uint64_t>(n) * static_cast<uint64_t>(_M);
+  }
+
   inline void swapNodes(node_id_t a, node_id_t b, void* temp_data, node_id_t* temp_links,
                         label_t* temp_label) {
+    if (_link_distances) {
+      std::swap_ranges(getLinkDistances(a), getLinkDistances(a) + _M, getLinkDistances(b));
+    }
 
     // stash b in temp
     std::memcpy(temp_data, getNodeData(b), _data_size_bytes);
@@ -699,24 +1578,19 @@ class Index {
   }
 
   void processCandidateNode(const void* query, node_id_t& node, float& max_dist, const int buffer_size,
-                            VisitedSet* visited_set, PriorityQueue& neighbors, PriorityQueue& candidates) {
+                            VisitedSet<node_id_t>* visited_set, PriorityQueue& neighbors, PriorityQueue& candidates) {
     // Lock all operations on this specific node
     std::unique_lock<std::mutex> lock(_node_links_mutexes[node]);
 
     // Update access frequency
-    auto least_frequent = _top_node_frequencies.begin();
-    auto node_handle = _top_node_frequencies.extract(node);
-    _node_frequencies[node]++;
-    
-    if (node_handle) {
-      _top_node_frequencies.insert(std::move(node_handle));
-    } else if (_node_frequencies[node] > *least_frequent) {
-      _top_node_frequencies.erase(least_frequent);
-      _top_node_frequencies.insert(node);
+    if (_entry_policy == EntryPolicy::Frequency) {
+      updateTopNodeFrequencies(node);
+    } else {
+      _node_frequencies[node]++;
     }
 
     node_id_t* neighbor_node_links = getNodeLinks(node);
-    for (uint32_t i = 0; i < _M; i++) {
+    for (size_t i = 0; i < _M; i++) {
       node_id_t neighbor_node_id = neighbor_node_links[i];
 
       // If using SSE, prefetch the next neighbor node data and the visited
@@ -758,12 +1632,44 @@ class Index {
     }
   }
 
+  /**
+   * @brief Increments the access frequency of `node` and keeps the tree of the
+   * most frequently accessed nodes ordered. The tree is keyed by frequency, so
+   * the frequency of a node in the tree must only change while it is
+   * extracted.
+   */
+  void updateTopNodeFrequencies(node_id_t node) {
+    std::unique_lock<std::mutex> lock(_top_node_frequencies_guard);
+
+    // Several nodes can share a frequency, so look for this exact node.
+    auto [first, last] = _top_node_frequencies.equal_range(node);
+    auto it = std::find(first, last, node);
+    if (it != last) {
+      auto node_handle = _top_node_frequencies.extract(it);
+      _node_frequencies[node]++;
+      _top_node_frequencies.insert(std::move(node_handle));
+      return;
+    }
+
+    _node_frequencies[node]++;
+    if (_top_node_frequencies.size() < _num_top_nodes) {
+      _top_node_frequencies.insert(node);
+      return;
+    }
+    auto least_frequent = _top_node_frequencies.begin();
+    if (_node_frequencies[node] > _node_frequencies[*least_frequent]) {
+      _top_node_frequencies.erase(least_frequent);
+      _top_node_frequencies.insert(node);
+    }
+  }
+
   /**
    * @brief Selects neighbors from the PriorityQueue, according to the HNSW
-   * heuristic. The neighbors priority queue contains elements sorted by
-   * distance where the top element is the furthest neighbor from the query.
+   * heuristic, relaxed by the `alpha` of the pruning configuration. The
+   * neighbors priority queue contains elements sorted by distance where the
+   * top element is the furthest neighbor from the query.
    */
-  void selectNeighbors(PriorityQueue& neighbors, int M) {
+  void selectNeighbors(PriorityQueue& neighbors, size_t M) {
     if (neighbors.size() < M) {
       return;
     }
@@ -771,6 +1677,7 @@ class Index {
     std::priority_queue<std::pair<float, node_id_t>> candidates;
     std::vector<dist_node_t> saved_candidates;
     saved_candidates.reserve(M);
+    std::vector<dist_node_t> pruned_candidates;
 
     while (neighbors.size() > 0) {
       auto [distance, id] = neighbors.top();
@@ -793,19 +1700,25 @@ class Index {
         float cur_dist = _distance->distance(/* x = */ getNodeData(second_pair_node_id),
                                        /* y = */ getNodeData(current_node_id));
 
-        if (cur_dist < distance_to_query) {
+        if (_pruning.alpha * cur_dist < distance_to_query) {
           should_keep_candidate = false;
           break;
         }
       }
+      // We could do neighbors.emplace except we have to iterate
+      // through saved_candidates, and std::priority_queue doesn't
+      // support iteration (there is no technical reason why not).
+      auto current_pair = std::make_pair(-distance_to_query, current_node_id);
       if (should_keep_candidate) {
-        // We could do neighbors.emplace except we have to iterate
-        // through saved_candidates, and std::priority_queue doesn't
-        // support iteration (there is no technical reason why not).
-        auto current_pair = std::make_pair(-distance_to_query, current_node_id);
         saved_candidates.push_back(current_pair);
+      } else if (_pruning.keep_pruned) {
+        pruned_candidates.push_back(current_pair);
       }
     }
+    // Pruned candidates were visited from the closest to the furthest.
+    for (size_t i = 0; i < pruned_candidates.size() && saved_candidates.size() < M; i++) {
+      saved_candidates.push_back(pruned_candidates[i]);
+    }
     // TODO: implement my own priority queue, get rid of vector
     // saved_candidates, add directly to neighborqueue earlier.
     for (const dist_node_t& current_pair : saved_candidates) {
@@ -824,20 +1737,33 @@ class Index {
     int i = 0;  // iterates through links for "new_node_id"
 
     while (neighbors.size() > 0) {
-      node_id_t neighbor_node_id = neighbors.top().second;
+      auto [neighbor_distance, neighbor_node_id] = neighbors.top();
       // add link to the current new node
       new_node_links[i] = neighbor_node_id;
+      if (_link_distances) {
+        getLinkDistances(new_node_id)[i] = neighbor_distance;
+      }
       // now do the back-connections (a little tricky)
 
       std::unique_lock<std::mutex> neighbor_lock(_node_links_mutexes[neighbor_node_id]);
       node_id_t* neighbor_node_links = getNodeLinks(neighbor_node_id);
       bool is_inserted = false;
       for (size_t j = 0; j < _M; j++) {
-        if (neighbor_node_links[j] == neighbor_node_id) {
+        if (neighbor_node_links[j] == new_node_id) {
+          // The back-edge already exists. This happens when an updated node
+          // is re-linked to one of its former neighbors. Links are packed
+          // before the self-loops, so this is always seen before a free slot.
+          is_inserted = true;
+        } else if (neighbor_node_links[j] == neighbor_node_id) {
           // If there is a self-loop, replace the self-loop with
           // the desired link.
           neighbor_node_links[j] = new_node_id;
           is_inserted = true;
+        }
+        if (is_inserted) {
+          if (_link_distances) {
+            getLinkDistances(neighbor_node_id)[j] = neighbor_distance;
+          }
           break;
         }
       }
@@ -847,33 +1773,7 @@ class Index {
         // very careful. To ensure we respect the pruning heuristic, we
         // construct a candidate set including the old links AND our new
         // one, then prune this candidate set to get the new neighbors.
-
-        float max_dist = _distance->distance(/* x = */ getNodeData(neighbor_node_id),
-                                             /* y = */ getNodeData(new_node_id));
-
-        PriorityQueue candidates;
-        candidates.emplace(max_dist, new_node_id);
-        for (size_t j = 0; j < _M; j++) {
-          if (neighbor_node_links[j] != neighbor_node_id) {
-            auto label = neighbor_node_links[j];
-            auto distance = _distance->distance(/* x = */ getNodeData(neighbor_node_id),
-                                                /* y = */ getNodeData(label));
-            candidates.emplace(distance, label);
-          }
-        }
-        // 2X larger than the previous call to selectNeighbors.
-        selectNeighbors(candidates, _M);
-        // connect the pruned set of candidates, including self-loops:
-        size_t j = 0;
-        while (candidates.size() > 0) {  // candidates
-          neighbor_node_links[j] = candidates.top().second;
-          candidates.pop();
-          j++;
-        }
-        while (j < _M) {  // self-loops (unused links)
-          neighbor_node_links[j] = neighbor_node_id;
-          j++;
-        }
+        pruneNodeLinks(/* node_id = */ neighbor_node_id, /* candidate_id = */ new_node_id);
       }
 
       // Unlock the current node we are iterating over
@@ -885,6 +1785,373 @@ class Index {
     }
   }
 
+  /**
+   * @brief Re-selects the links of a node from its current links plus one
+   * candidate, using the pruning heuristic. Unused slots are filled with
+   * self-loops. The caller must hold the links mutex of `node_id`.
+   *
+   * @param node_id The node whose links are re-selected.
+   * @param candidate_id The node to consider in addition to the current links.
+   * It may already be one of them.
+   */
+  void pruneNodeLinks(node_id_t node_id, node_id_t candidate_id) {
+    node_id_t* links = getNodeLinks(node_id);
+
+    PriorityQueue candidates;
+    candidates.emplace(_distance->distance(/* x = */ getNodeData(node_id),
+                                           /* y = */ getNodeData(candidate_id)),
+                       candidate_id);
+    for (size_t j = 0; j < _M; j++) {
+      if (links[j] != node_id && links[j] != candidate_id) {
+        candidates.emplace(linkDistance(node_id, j), links[j]);
+      }
+    }
+    // 2X larger than the previous call to selectNeighbors by default.
+    selectNeighbors(candidates, backwardDegree());
+    writeNodeLinks(node_id, candidates);
+  }
+
+  /**
+   * @brief Returns the distance from `node_id` to its link in slot `j`, from
+   * the link distance cache when it is enabled.
+   */
+  inline float linkDistance(node_id_t node_id, size_t j) const {
+    if (_link_distances) {
+      return getLinkDistances(node_id)[j];
+    }
+    return _distance->distance(/* x = */ getNodeData(node_id), /* y = */ getNodeData(getNodeLinks(node_id)[j]));
+  }
+
+  /**
+   * @brief Replaces the links of `node_id` with the nodes in `neighbors`,
+   * followed by self-loops for the unused slots. `neighbors` is emptied.
+   */
+  void writeNodeLinks(node_id_t node_id, PriorityQueue& neighbors) {
+    node_id_t* links = getNodeLinks(node_id);
+    float* distances = _link_distances ? getLinkDistances(node_id) : nullptr;
+    size_t j = 0;
+    while (neighbors.size() > 0) {  // candidates
+      links[j] = neighbors.top().second;
+      if (distances) {
+        distances[j] = neighbors.top().first;
+      }
+      neighbors.pop();
+      j++;
+    }
+    while (j < _M) {  // self-loops (unused links)
+      links[j] = node_id;
+      j++;
+    }
+  }
+
+  // Number of links selected for a new node.
+  inline int forwardDegree() const {
+    return _pruning.forward_degree ? static_cast<int>(_pruning.forward_degree)
+                                   : std::max(static_cast<int>(_M / 2), 1);
+  }
+
+  // Number of links kept when a full link list is pruned.
+  inline int backwardDegree() const {
+    return _pruning.backward_degree ? static_cast<int>(_pruning.backward_degree) : static_cast<int>(_M);
+  }
+
+  /**
+   * @brief Runs `function` on every index in [start_index, end_index) using
+   * `_num_threads` threads.
+   */
+  template <typename Function>
+  void parallelFor(uint64_t start_index, uint64_t end_index, Function function) {
+    // Don't spawn any threads if we are only using one.
+    if (_num_threads == 1) {
+      for (uint64_t index = start_index; index < end_index; index++) {
+        function(index);
+      }
+      return;
+    }
+    flatnav::executeInParallel(/* start_index = */ start_index, /* end_index = */ end_index,
+                               /* num_threads = */ _num_threads, /* function = */ function);
+  }
+
+  /**
+   * @brief Search phase of `addBulk`. Selects the out-links of the nodes
+   * [first_node_id, first_node_id + queries.size()) with parallel beam
+   * searches. The graph is only read.
+   *
+   * @param queries The vector of every node in the batch.
+   * @param first_node_id The id of the first node in the batch.
+   * @param ef_construction The search beam width.
+   * @param num_initializations Number of initializations for the search
+   * algorithm.
+   * @param relink If true, the nodes are already linked. The search may then
+   * find the node itself, which is skipped, and its current links are also
+   * candidates. Up to M links are selected instead of M / 2.
+   * @return The selected links of every node in the batch, with their
+   * distances.
+   */
+  std::vector<std::vector<dist_node_t>> searchBatchNeighbors(const std::vector<const void*>& queries,
+                                                           node_id_t first_node_id, int ef_construction,
+                                                           int num_initializations, bool relink) {
+    std::vector<std::vector<dist_node_t>> batch_links(queries.size());
+
+    parallelFor(0, queries.size(), [&](uint64_t batch_index) {
+      node_id_t node_id = first_node_id + batch_index;
+      std::vector<char> query_buffer;
+      const void* query = _distance->transformQuery(queries[batch_index], query_buffer);
+      node_id_t entry_node = initializeSearch(query, num_initializations);
+      PriorityQueue candidates = beamSearch(/* query = */ query, /* entry_node = */ entry_node,
+                                            /* buffer_size = */ ef_construction);
+
+      PriorityQueue neighbors;
+      std::vector<node_id_t> seen;
+      seen.reserve(candidates.size());
+      while (!candidates.empty()) {
+        if (candidates.top().second != node_id) {
+          neighbors.push(candidates.top());
+          seen.push_back(candidates.top().second);
+        }
+        candidates.pop();
+      }
+
+      int selection_M = forwardDegree();
+      if (relink) {
+        node_id_t* links = getNodeLinks(node_id);
+        for (size_t i = 0; i < _M && links[i] != node_id; i++) {
+          if (std::find(seen.begin(), seen.end(), links[i]) == seen.end()) {
+            neighbors.emplace(_distance->distance(/* x = */ query, /* y = */ getNodeData(links[i]),
+                                                  /* asymmetric = */ true),
+                              links[i]);
+          }
+        }
+        selection_M = _M;
+      }
+      selectNeighbors(/* neighbors = */ neighbors, /* M = */ selection_M);
+
+      std::vector<dist_node_t>& node_links = batch_links[batch_index];
+      node_links.reserve(neighbors.size());
+      while (!neighbors.empty()) {
+        node_links.push_back(neighbors.top());
+        neighbors.pop();
+      }
+    });
+
+    return batch_links;
+  }
+
+  /**
+   * @brief Commit phase of `addBulk`. Writes the out-links selected by
+   * `searchBatchNeighbors` and merges the reverse edges into their targets.
+   * Reverse edges are grouped by target, so every node is modified by exactly
+   * one thread and no locks are taken.
+   */
+  void commitBatchLinks(node_id_t first_node_id, const std::vector<std::vector<dist_node_t>>& batch_links) {
+    writeBatchLinks(first_node_id, batch_links);
+    addReverseEdges(first_node_id, batch_links);
+  }
+
+  /**
+   * @brief Replaces the links of the nodes [first_node_id, first_node_id +
+   * batch_links.size()) with `batch_links`, in parallel.
+   */
+  void writeBatchLinks(node_id_t first_node_id, const std::vector<std::vector<dist_node_t>>& batch_links) {
+    parallelFor(0, batch_links.size(), [&](uint64_t batch_index) {
+      node_id_t node_id = first_node_id + batch_index;
+      PriorityQueue neighbors(CompareByFirst(), batch_links[batch_index]);
+      writeNodeLinks(node_id, neighbors);
+    });
+  }
+
+  /**
+   * @brief Merges the reverse of every edge in `batch_links` into its target.
+   * Sources are processed in chunks to bound the memory used for grouping.
+   * Within a chunk, edges are grouped by target, so every target is modified
+   * by exactly one thread and no locks are taken.
+   */
+  void addReverseEdges(node_id_t first_node_id, const std::vector<std::vector<dist_node_t>>& batch_links) {
+    static constexpr size_t SOURCES_PER_CHUNK = 1 << 20;
+
+    for (size_t chunk_start = 0; chunk_start < batch_links.size(); chunk_start += SOURCES_PER_CHUNK) {
+      size_t chunk_end = std::min(chunk_start + SOURCES_PER_CHUNK, batch_links.size());
+
+      // (target, (distance, source)) pairs, sorted so that the edges of a
+      // target are contiguous.
+      std::vector<std::pair<node_id_t, dist_node_t>> reverse_edges;
+      for (size_t batch_index = chunk_start; batch_index < chunk_end; batch_index++) {
+        for (const auto& [distance, target] : batch_links[batch_index]) {
+          reverse_edges.push_back({target, {distance, static_cast<node_id_t>(first_node_id + batch_index)}});
+        }
+      }
+      std::sort(reverse_edges.begin(), reverse_edges.end());
+
+      std::vector<size_t> group_offsets;
+      for (size_t i = 0; i < reverse_edges.size(); i++) {
+        if (i == 0 || reverse_edges[i].first != reverse_edges[i - 1].first) {
+          group_offsets.push_back(i);
+        }
+      }
+      group_offsets.push_back(reverse_edges.size());
+
+      parallelFor(0, group_offsets.size() - 1, [&](uint64_t group) {
+        node_id_t target = reverse_edges[group_offsets[group]].first;
+        std::vector<dist_node_t> sources;
+        sources.reserve(group_offsets[group + 1] - group_offsets[group]);
+        for (size_t i = group_offsets[group]; i < group_offsets[group + 1]; i++) {
+          sources.push_back(reverse_edges[i].second);
+        }
+        mergeNodeLinks(/* node_id = */ target, /* new_links = */ sources);
+      });
+    }
+  }
+
+  /**
+   * @brief Adds links from `node_id` to every node of `new_links`, given with
+   * their distance to `node_id`. Free slots are used first. If there are not
+   * enough, the current and new links are pruned together with the selection
+   * heuristic, as in `pruneNodeLinks`. The caller must have exclusive access to
+   * the links of `node_id`.
+   */
+  void mergeNodeLinks(node_id_t node_id, const std::vector<dist_node_t>& new_links) {
+    node_id_t* links = getNodeLinks(node_id);
+    // Links are packed before the self-loops.
+    size_t num_links = 0;
+    while (num_links < _M && links[num_links] != node_id) {
+      num_links++;
+    }
+
+    std::vector<dist_node_t> overflow;
+    for (const auto& [distance, candidate_id] : new_links) {
+      if (candidate_id == node_id || std::find(links, links + num_links, candidate_id) != links + num_links) {
+        continue;
+      }
+      if (num_links < _M) {
+        if (_link_distances) {
+          getLinkDistances(node_id)[num_links] = distance;
+        }
+        links[num_links++] = candidate_id;
+      } else {
+        overflow.emplace_back(distance, candidate_id);
+      }
+    }
+    if (overflow.empty()) {
+      return;
+    }
+
+    PriorityQueue candidates(CompareByFirst(), std::move(overflow));
+    for (size_t j = 0; j < _M; j++) {
+      candidates.emplace(linkDistance(node_id, j), links[j]);
+    }
+    selectNeighbors(candidates, backwardDegree());
+    writeNodeLinks(node_id, candidates);
+  }
+
+  /**
+   * @brief Hands out the next free node id.
+   *
+   * @exception std::runtime_error Thrown if the maximum number of nodes is
+   * reached.
+   */
+  node_id_t reserveNode() {
+    size_t new_node_id = _num_reserved_nodes.fetch_add(1, std::memory_order_relaxed);
+    if (new_node_id >= _max_node_count) {
+      throw std::runtime_error(
+          "Maximum number of nodes reached. Consider "
+          "increasing the `max_node_count` parameter to "
+          "create a larger index.");
+    }
+    return static_cast<node_id_t>(new_node_id);
+  }
+
+  /**
+   * @brief Writes the data, label and self-loop links of a reserved node. The
+   * node is not visible to searches until it is published. The links are
+   * written first, so that a node published after a failure here is isolated.
+   */
+  void initializeNode(void* data, label_t& label, node_id_t new_node_id) {
+    node_id_t* links = getNodeLinks(new_node_id);
+    // Initialize all edges to self
+    std::fill_n(links, _M, new_node_id);
+    _distance->transformData(
+        /* destination = */ getNodeData(new_node_id),
+        /* src = */ data);
+    *(getNodeLabel(new_node_id)) = label;
+  }
+
+  /**
+   * @brief Makes a reserved, initialized node visible to searches. Nodes are
+   * published in id order so that [0, _cur_num_nodes) never contains a
+   * partially written node. In `add`, a predecessor publishes only after
+   * selecting its entry point (a full `initializeSearch`), so a stalled insert
+   * holds up every insert with a larger id.
+   *
+   * The label map is updated here, in id order, so that a re-added label
+   * refers to its latest node just as the linear scan in `findNode` does.
+   */
+  void publishNode(node_id_t new_node_id) {
+    while (_cur_num_nodes.load(std::memory_order_acquire) != new_node_id) {
+      std::this_thread::yield();
+    }
+
+    if (_entry_policy == EntryPolicy::Frequency) {
+      std::unique_lock<std::mutex> lock(_top_node_frequencies_guard);
+      if (_top_node_frequencies.size() < _num_top_nodes) {
+        _top_node_frequencies.insert(new_node_id);
+      }
+    }
+
+    // The map entry and the node count change under one lock, so lookups never
+    // see an unpublished node in the map.
+    std::unique_lock<std::shared_mutex> lock(_label_map_guard, std::defer_lock);
+    if (_label_map) {
+      lock.lock();
+      _label_map->insert(*getNodeLabel(new_node_id), new_node_id,
+                         [this](node_id_t n) -> const label_t& { return *getNodeLabel(n); });
+    }
+    _cur_num_nodes.store(static_cast<size_t>(new_node_id) + 1, std::memory_order_release);
+  }
+
+  /**
+   * @brief Returns the id of the node holding `label`, if any. This uses the
+   * label map when it is enabled and falls back to a linear scan over the
+   * labels of all nodes otherwise. Both return the largest matching id. Only
+   * published nodes are found, so this is safe to call while other threads add
+   * vectors.
+   */
+  std::optional<node_id_t> findNode(const label_t& label) const {
+    if (_label_map) {
+      // Inserts write map slots without atomics, so reads take a shared lock.
+      std::shared_lock<std::shared_mutex> lock(_label_map_guard);
+      return _label_map->find(label, [this](node_id_t n) -> const label_t& { return *getNodeLabel(n); });
+    }
+    for (size_t node = _cur_num_nodes.load(std::memory_order_acquire); node-- > 0;) {
+      if (*getNodeLabel(static_cast<node_id_t>(node)) == label) {
+        return static_cast<node_id_t>(node);
+      }
+    }
+    return std::nullopt;
+  }
+
+  /**
+   * @brief Returns the nodes that the entry policy starts searches from with
+   * `num_initializations` initializations. Random and Ideal entry points may be
+   * any node, so the strided sample stands in for them.
+   */
+  std::vector<node_id_t> entryNodes(int num_initializations) {
+    size_t num_nodes = _cur_num_nodes;
+    std::vector<node_id_t> entry_nodes;
+    if (_entry_policy == EntryPolicy::Fixed) {
+      entry_nodes.push_back(0);
+    } else if (_entry_policy == EntryPolicy::Frequency) {
+      std::unique_lock<std::mutex> lock(_top_node_frequencies_guard);
+      entry_nodes.assign(_top_node_frequencies.begin(), _top_node_frequencies.end());
+    }
+    if (entry_nodes.empty()) {
+      size_t step_size = std::max<size_t>(num_nodes / num_initializations, 1);
+      for (size_t node = 0; node < num_nodes; node += step_size) {
+        entry_nodes.push_back(node);
+      }
+    }
+    return entry_nodes;
+  }
+
   /**
    * @brief Selects a node to use as the entry point for a new node.
    * This proceeds in a greedy fashion, by selecting the node with
@@ -902,6 +2169,9 @@ class Index {
 
     float min_dist = std::numeric_limits<float>::max();
     node_id_t entry_node = 0;
+    // Only published nodes are candidates. Concurrent inserts may publish
+    // more while this runs, which is harmless.
+    size_t num_nodes = _cur_num_nodes.load(std::memory_order_acquire);
 
     switch (_entry_policy) {
     case EntryPolicy::Fixed: {
@@ -915,10 +2185,10 @@ class Index {
         _distance_computations.fetch_add(num_initializations);
       }
       
-      int step_size = _cur_num_nodes / num_initializations;
+      size_t step_size = num_nodes / num_initializations;
       step_size = step_size ? step_size : 1;
 
-      for (node_id_t node = 0; node < _cur_num_nodes; node += step_size) {
+      for (node_id_t node = 0; node < num_nodes; node += step_size) {
         float dist = _distance->distance(/* x = */ query, /* y = */ getNodeData(node),
                                         /* asymmetric = */ true);
         if (dist < min_dist) {
@@ -934,7 +2204,7 @@ class Index {
       }
       
       for (int i = 0; i < num_initializations; i++) {
-        node_id_t node = rand() % _cur_num_nodes;
+        node_id_t node = rand() % num_nodes;
         float dist = _distance->distance(query, getNodeData(node), true);
         if (dist < min_dist) {
           min_dist = dist;
@@ -948,7 +2218,12 @@ class Index {
         _distance_computations.fetch_add(num_initializations);
       }
 
-      for (node_id_t node : _top_node_frequencies) {
+      std::vector<node_id_t> top_nodes;
+      {
+        std::unique_lock<std::mutex> lock(_top_node_frequencies_guard);
+        top_nodes.assign(_top_node_frequencies.begin(), _top_node_frequencies.end());
+      }
+      for (node_id_t node : top_nodes) {
         float dist = _distance->distance(query, getNodeData(node), true);
         if (dist < min_dist) {
           min_dist = dist;
@@ -962,7 +2237,7 @@ class Index {
         _distance_computations.fetch_add(1);
       }
 
-      for (node_id_t node = 0; node < _cur_num_nodes; node++) {
+      for (node_id_t node = 0; node < num_nodes; node++) {
         float dist = _distance->distance(query, getNodeData(node), true);
         if (dist < min_dist) {
           min_dist = dist;
@@ -976,14 +2251,88 @@ class Index {
     return entry_node;
   }
 
+  /**
+   * @brief Moves every node n to position P[n]. Nodes are copied in parallel
+   * into a new buffer, with their links rewired on the way, which then
+   * replaces the index memory. If the second buffer cannot be allocated, the
+   * nodes are permuted in place instead.
+   */
   void relabel(const std::vector<node_id_t>& P) {
+    uint64_t index_size = static_cast<uint64_t>(_node_size_bytes) * static_cast<uint64_t>(_max_node_count);
+    char* relabeled_memory = new (std::nothrow) char[index_size];
+    std::unique_ptr<float[]> relabeled_link_distances;
+    if (relabeled_memory && _link_distances) {
+      relabeled_link_distances.reset(new (std::nothrow) float[_max_node_count * _M]);
+      if (!relabeled_link_distances) {
+        delete[] relabeled_memory;
+        relabeled_memory = nullptr;
+      }
+    }
+
+    if (relabeled_memory) {
+      parallelFor(0, _cur_num_nodes, [&](uint64_t n) {
+        char* destination = relabeled_memory + static_cast<uint64_t>(P[n]) * _node_size_bytes;
+        std::memcpy(destination, getNodeData(n), _node_size_bytes);
+        node_id_t* links = reinterpret_cast<node_id_t*>(destination + _data_size_bytes);
+        for (size_t m = 0; m < _M; m++) {
+          links[m] = P[links[m]];
+        }
+        if (_link_distances) {
+          std::memcpy(relabeled_link_distances.get() + static_cast<uint64_t>(P[n]) * _M, getLinkDistances(n),
+                      _M * sizeof(float));
+        }
+      });
+      delete[] _index_memory;
+      _index_memory = relabeled_memory;
+      if (_link_distances) {
+        _link_distances = std::move(relabeled_link_distances);
+      }
+    } else {
+      relabelInPlace(P);
+    }
+
+    // Rebuilding the map in the new id order keeps re-added labels on the node
+    // with the largest id, as the linear scan finds them.
+    if (_label_map) {
+      enableLabelLookup();
+    }
+
+    // Visit counts follow their nodes. The vector is updated in place because
+    // the top-frequency tree's comparator points to it.
+    std::vector<uint32_t> frequencies(_node_frequencies);
+    for (size_t node = 0; node < P.size(); node++) {
+      _node_frequencies[P[node]] = frequencies[node];
+    }
+    {
+      std::unique_lock<std::mutex> lock(_top_node_frequencies_guard);
+      std::vector<node_id_t> top_nodes(_top_node_frequencies.begin(), _top_node_frequencies.end());
+      _top_node_frequencies.clear();
+      for (node_id_t node : top_nodes) {
+        _top_node_frequencies.insert(P[node]);
+      }
+    }
+
+    // Record the composed permutation. Nodes added since the last reordering
+    // were at their insertion position.
+    size_t num_recorded = _permutation.size();
+    _permutation.resize(P.size());
+    for (size_t node = num_recorded; node < P.size(); node++) {
+      _permutation[node] = node;
+    }
+    for (auto& node : _permutation) {
+      node = P[node];
+    }
+  }
+
+  // Fallback of `relabel` that needs no second copy of the index.
+  void relabelInPlace(const std::vector<node_id_t>& P) {
     // 1. Rewire all of the node connections
-    for (node_id_t n = 0; n < _cur_num_nodes; n++) {
+    parallelFor(0, _cur_num_nodes, [&](uint64_t n) {
       node_id_t* links = getNodeLinks(n);
-      for (int m = 0; m < _M; m++) {
+      for (size_t m = 0; m < _M; m++) {
         links[m] = P[links[m]];
       }
-    }
+    });
 
     // 2. Physically re-layout the nodes (in place)
     char* temp_data = new char[_data_size_bytes];
@@ -2,9 +2,13 @@
 #include <flatnav/util/Macros.h>
 #include <flatnav/util/SimdUtils.h>
 #include <chrono>
+#include <cmath>
 #include <random>
+#include <sstream>
+#include <vector>
 #include "gtest/gtest.h"
 
+#include <flatnav/distances/CosineDistance.h>
 #include <flatnav/distances/InnerProductDistance.h>
 #include <flatnav/distances/SquaredL2Distance.h>
 
@@ -35,17 +39,24 @@ class DistanceTest : public ::testing::Test {
 
 // Test case for AVX512-based L2 distance computer
 TEST_F(DistanceTest, TestAvx512L2Distance) {
-#if defined(USE_AVX512)
-  float result = flatnav::util::computeL2_Avx512(x, y, dimensions);
-  float expected = flatnav::distances::defaultSquaredL2<float>(x, y, dimensions);
-  ASSERT_NEAR(result, expected, epsilon);
-
+#if defined(BUILD_AVX512_KERNELS)
+  if (platformSupportsAvx512Bw()) {
+    // The kernel handles any dimension, including a masked tail.
+    for (size_t dimension : {dimensions, size_t(100), size_t(37), size_t(7)}) {
+      float result = flatnav::util::computeL2_Avx512(x, y, dimension);
+      float expected = flatnav::distances::defaultSquaredL2<float>(x, y, dimension);
+      ASSERT_NEAR(result, expected, epsilon);
+    }
+  }
 #endif
 }
 
 // Test case for AVX512-based L2 distance computer for uint8_t data type
 TEST_F(DistanceTest, TestAvx512L2DistanceUint8) {
-#if defined(USE_AVX512)
+#if defined(BUILD_AVX512_KERNELS)
+  if (!platformSupportsAvx512Bw()) {
+    return;
+  }
   auto total_num_vectors = 1000;
   auto total_size = dimensions * total_num_vectors;
   uint8_t* x_matrix = (uint8_t*)malloc(total_size);
@@ -71,13 +82,14 @@ TEST_F(DistanceTest, TestAvx512L2DistanceUint8) {
 
 // Test case for AVX-based L2 distance computer
 TEST_F(DistanceTest, TestAvxL2Distance) {
-#if defined(USE_AVX)
-
-  float result = flatnav::util::computeL2_Avx2(x, y, dimensions);
-  float expected = flatnav::distances::defaultSquaredL2<float>(x, y, dimensions);
-
-  ASSERT_NEAR(result, expected, epsilon);
-
+#if defined(BUILD_AVX2_KERNELS)
+  if (platformSupportsAvx2()) {
+    for (size_t dimension : {dimensions, size_t(100), size_t(37), size_t(7)}) {
+      float result = flatnav::util::computeL2_Avx2(x, y, dimension);
+      float expected = flatnav::distances::defaultSquaredL2<float>(x, y, dimension);
+      ASSERT_NEAR(result, expected, epsilon);
+    }
+  }
 #endif
 }
 
@@ -128,21 +140,27 @@ TEST_F(DistanceTest, TestSseL2Distance) {
 
 // Test case for AVX512-based inner product distance computer
 TEST_F(DistanceTest, TestAvx512InnerProductDistance) {
-#if defined(USE_AVX512)
-  float result = flatnav::util::computeIP_Avx512(x, y, dimensions);
-  float expected = flatnav::distances::defaultInnerProduct(x, y, dimensions);
-  ASSERT_NEAR(result, expected, epsilon);
-
+#if defined(BUILD_AVX512_KERNELS)
+  if (platformSupportsAvx512Bw()) {
+    for (size_t dimension : {dimensions, size_t(100), size_t(37), size_t(7)}) {
+      float result = flatnav::util::computeIP_Avx512(x, y, dimension);
+      float expected = flatnav::distances::defaultInnerProduct(x, y, dimension);
+      ASSERT_NEAR(result, expected, epsilon);
+    }
+  }
 #endif
 }
 
 // Test case for AVX-based inner product distance computer
 TEST_F(DistanceTest, TestAvxInnerProductDistance) {
-#if defined(USE_AVX)
-  float result = flatnav::util::computeIP_Avx(x, y, dimensions);
-  float expected = flatnav::distances::defaultInnerProduct(x, y, dimensions);
-  ASSERT_NEAR(result, expected, epsilon);
-
+#if defined(BUILD_AVX2_KERNELS)
+  if (platformSupportsAvx2()) {
+    for (size_t dimension : {dimensions, size_t(100), size_t(37), size_t(7)}) {
+      float result = flatnav::util::computeIP_Avx(x, y, dimension);
+      float expected = flatnav::distances::defaultInnerProduct(x, y, dimension);
+      ASSERT_NEAR(result, expected, epsilon);
+    }
+  }
 #endif
 }
 
@@ -159,12 +177,6 @@ TEST_F(DistanceTest, TestSseInnerProductDistance) {
   expected = flatnav::distances::defaultInnerProduct(x, y, 100);
   ASSERT_NEAR(result, expected, epsilon);
 
-#if defined(USE_AVX)
-  result = flatnav::util::computeIP_Avx_4aligned(x, y, 100);
-  expected = flatnav::distances::defaultInnerProduct(x, y, 100);
-  ASSERT_NEAR(result, expected, epsilon);
-#endif
-
   // try with dimensions not divisible by 4
   result = flatnav::util::computeIP_SseWithResidual_16(x, y, 37);
   expected = flatnav::distances::defaultInnerProduct(x, y, 37);
@@ -178,4 +190,285 @@ TEST_F(DistanceTest, TestSseInnerProductDistance) {
 #endif
 }
 
+// Distances resolve their kernel once, for their dimension. Every dimension,
+// including those that no kernel handles (e.g. 3), gets one that matches the
+// scalar code, and so does a distance restored from an archive.
+TEST_F(DistanceTest, TestResolvedDistanceFunctions) {
+  using flatnav::distances::InnerProductDistance;
+  using flatnav::distances::SquaredL2Distance;
+  for (size_t dimension : {size_t(1), size_t(3), size_t(4), size_t(7), size_t(16), size_t(37), size_t(100),
+                           dimensions}) {
+    SquaredL2Distance<> l2_distance(dimension);
+    InnerProductDistance<> ip_distance(dimension);
+    float expected_l2 = flatnav::distances::defaultSquaredL2<float>(x, y, dimension);
+    float expected_ip = flatnav::distances::defaultInnerProduct(x, y, dimension);
+    ASSERT_NEAR(l2_distance.distance(x, y), expected_l2, epsilon);
+    ASSERT_NEAR(ip_distance.distance(x, y), expected_ip, epsilon);
+
+    std::stringstream stream;
+    {
+      cereal::BinaryOutputArchive archive(stream);
+      archive(l2_distance);
+    }
+    SquaredL2Distance<> loaded;
+    {
+      cereal::BinaryInputArchive archive(stream);
+      archive(loaded);
+    }
+    ASSERT_EQ(loaded.distance(x, y), l2_distance.distance(x, y));
+  }
+}
+
+// Test case for the 8-bit inner product kernels, including dimensions that
+// leave a tail after the last full register.
+TEST(TestIntegerDistances, TestInnerProductInt8AndUint8) {
+  std::mt19937 generator(1234);
+  std::uniform_int_distribution<int> distribution(0, 255);
+  for (size_t dimension : {1, 7, 16, 37, 64, 100, 128, 200, 784}) {
+    std::vector<uint8_t> x(dimension), y(dimension);
+    for (size_t i = 0; i < dimension; i++) {
+      x[i] = distribution(generator);
+      y[i] = distribution(generator);
+    }
+    // The same bytes, read as int8_t, cover negative values.
+    const int8_t* x_int8 = reinterpret_cast<const int8_t*>(x.data());
+    const int8_t* y_int8 = reinterpret_cast<const int8_t*>(y.data());
+    // The kernels accumulate in integers, so they are exact.
+    int32_t inner_product_int8 = 0, inner_product_uint8 = 0;
+    for (size_t i = 0; i < dimension; i++) {
+      inner_product_int8 += x_int8[i] * y_int8[i];
+      inner_product_uint8 += x[i] * y[i];
+    }
+    float expected_int8 = 1.0f - static_cast<float>(inner_product_int8);
+    float expected_uint8 = 1.0f - static_cast<float>(inner_product_uint8);
+
+    ASSERT_EQ(flatnav::distances::IPDistanceDispatcher::dispatch(x_int8, y_int8, dimension), expected_int8);
+    ASSERT_EQ(flatnav::distances::IPDistanceDispatcher::dispatch(x.data(), y.data(), dimension), expected_uint8);
+#if defined(USE_SSE4_1)
+    ASSERT_EQ(flatnav::util::computeIP_Sse_int8(x_int8, y_int8, dimension), expected_int8);
+    ASSERT_EQ(flatnav::util::computeIP_Sse_uint8(x.data(), y.data(), dimension), expected_uint8);
+#endif
+#if defined(BUILD_AVX2_KERNELS)
+    if (platformSupportsAvx2()) {
+      ASSERT_EQ(flatnav::util::computeIP_Avx2_int8(x_int8, y_int8, dimension), expected_int8);
+      ASSERT_EQ(flatnav::util::computeIP_Avx2_uint8(x.data(), y.data(), dimension), expected_uint8);
+    }
+#endif
+#if defined(BUILD_AVX512_KERNELS)
+    if (platformSupportsAvx512Bw()) {
+      ASSERT_EQ(flatnav::util::computeIP_Avx512_int8(x_int8, y_int8, dimension), expected_int8);
+      ASSERT_EQ(flatnav::util::computeIP_Avx512_uint8(x.data(), y.data(), dimension), expected_uint8);
+    }
+#endif
+#if defined(BUILD_AVX512VNNI_KERNELS)
+    if (platformSupportsAvx512Vnni()) {
+      ASSERT_EQ(flatnav::util::computeIP_Avx512Vnni_int8(x_int8, y_int8, dimension), expected_int8);
+      ASSERT_EQ(flatnav::util::computeIP_Avx512Vnni_uint8(x.data(), y.data(), dimension), expected_uint8);
+    }
+#endif
+  }
+}
+
+// Test case for the 8-bit squared L2 kernels, including dimensions that leave
+// a tail after the last full register.
+TEST(TestIntegerDistances, TestSquaredL2Int8AndUint8) {
+  std::mt19937 generator(1234);
+  std::uniform_int_distribution<int> distribution(0, 255);
+  for (size_t dimension : {1, 7, 16, 37, 64, 100, 128, 200, 784}) {
+    std::vector<uint8_t> x(dimension), y(dimension);
+    for (size_t i = 0; i < dimension; i++) {
+      x[i] = distribution(generator);
+      y[i] = distribution(generator);
+    }
+    const int8_t* x_int8 = reinterpret_cast<const int8_t*>(x.data());
+    const int8_t* y_int8 = reinterpret_cast<const int8_t*>(y.data());
+    int32_t squared_distance_int8 = 0, squared_distance_uint8 = 0;
+    for (size_t i = 0; i < dimension; i++) {
+      squared_distance_int8 += (x_int8[i] - y_int8[i]) * (x_int8[i] - y_int8[i]);
+      squared_distance_uint8 += (x[i] - y[i]) * (x[i] - y[i]);
+    }
+    float expected_int8 = static_cast<float>(squared_distance_int8);
+    float expected_uint8 = static_cast<float>(squared_distance_uint8);
+
+    ASSERT_EQ(flatnav::distances::L2DistanceDispatcher::dispatch(x_int8, y_int8, dimension), expected_int8);
+    ASSERT_EQ(flatnav::distances::L2DistanceDispatcher::dispatch(x.data(), y.data(), dimension), expected_uint8);
+#if defined(USE_SSE4_1)
+    ASSERT_EQ(flatnav::util::computeL2_Sse_int8(x_int8, y_int8, dimension), expected_int8);
+    ASSERT_EQ(flatnav::util::computeL2_Sse_uint8(x.data(), y.data(), dimension), expected_uint8);
+#endif
+#if defined(BUILD_AVX2_KERNELS)
+    if (platformSupportsAvx2()) {
+      ASSERT_EQ(flatnav::util::computeL2_Avx2_int8(x_int8, y_int8, dimension), expected_int8);
+      ASSERT_EQ(flatnav::util::computeL2_Avx2_uint8(x.data(), y.data(), dimension), expected_uint8);
+    }
+#endif
+#if defined(BUILD_AVX512_KERNELS)
+    if (platformSupportsAvx512Bw()) {
+      ASSERT_EQ(flatnav::util::computeL2_Avx512_int8(x_int8, y_int8, dimension), expected_int8);
+      ASSERT_EQ(flatnav::util::computeL2_Avx512_Uint8(x.data(), y.data(), dimension), expected_uint8);
+    }
+#endif
+#if defined(BUILD_AVX512VNNI_KERNELS)
+    if (platformSupportsAvx512Vnni()) {
+      ASSERT_EQ(flatnav::util::computeL2_Avx512Vnni_int8(x_int8, y_int8, dimension), expected_int8);
+      ASSERT_EQ(flatnav::util::computeL2_Avx512Vnni_uint8(x.data(), y.data(), dimension), expected_uint8);
+    }
+#endif
+  }
+}
+
+// Every float16 and bfloat16 value survives a round trip through float32, and
+// floats round to the nearest 16-bit value, with ties to even.
+TEST(TestHalfPrecision, TestConversions) {
+  for (uint32_t bits = 0; bits <= 0xFFFF; bits++) {
+    util::float16_t half{static_cast<uint16_t>(bits)};
+    util::bfloat16_t bhalf{static_cast<uint16_t>(bits)};
+    // NaNs are only checked to stay NaNs (their payload is quieted).
+    bool is_nan = (bits & 0x7C00) == 0x7C00 && (bits & 0x3FF);
+    uint16_t round_trip = util::toFloat16(util::toFloat(half)).bits;
+    ASSERT_EQ(is_nan ? (round_trip & 0x7E00) == 0x7E00 : round_trip == bits, true);
+    bool is_bnan = (bits & 0x7F80) == 0x7F80 && (bits & 0x7F);
+    uint16_t bround_trip = util::toBfloat16(util::toFloat(bhalf)).bits;
+    ASSERT_EQ(is_bnan ? (bround_trip & 0x7FC0) == 0x7FC0 : bround_trip == bits, true);
+  }
+
+  ASSERT_EQ(util::toFloat(util::toFloat16(1.0f + std::ldexp(1.0f, -11))), 1.0f);
+  ASSERT_EQ(util::toFloat(util::toFloat16(1.0f + 3 * std::ldexp(1.0f, -11))), 1.0f + std::ldexp(1.0f, -9));
+  ASSERT_EQ(util::toFloat(util::toFloat16(65519.0f)), 65504.0f);
+  ASSERT_EQ(util::toFloat16(65520.0f).bits, 0x7C00);
+  ASSERT_EQ(util::toFloat(util::toFloat16(std::ldexp(1.0f, -24))), std::ldexp(1.0f, -24));
+  ASSERT_EQ(util::toFloat16(std::ldexp(1.0f, -25)).bits, 0);
+  ASSERT_EQ(util::toFloat(util::toBfloat16(1.0f + std::ldexp(1.0f, -8))), 1.0f);
+  ASSERT_EQ(util::toFloat(util::toBfloat16(1.0f + 3 * std::ldexp(1.0f, -8))), 1.0f + std::ldexp(1.0f, -6));
+
+#if defined(USE_F16C)
+  std::mt19937 generator(1234);
+  std::uniform_real_distribution<float> distribution(-70000.0f, 70000.0f);
+  for (int i = 0; i < 100000; i++) {
+    float value = distribution(generator) * std::ldexp(1.0f, -(i % 40));
+    ASSERT_EQ(util::toFloat16(value).bits, _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT));
+  }
+#endif
+}
+
+template <typename T>
+void checkHalfPrecisionDistances() {
+  std::mt19937 generator(1234);
+  std::normal_distribution<float> distribution(0.0f, 1.0f);
+  for (size_t dimension : {1, 7, 16, 37, 64, 100, 128, 200, 784}) {
+    std::vector<float> query(dimension), x(dimension), y(dimension);
+    std::vector<T> x_half(dimension), y_half(dimension);
+    for (size_t i = 0; i < dimension; i++) {
+      query[i] = distribution(generator);
+      x[i] = distribution(generator);
+      y[i] = distribution(generator);
+    }
+    util::convertFromFloat(x.data(), x_half.data(), dimension);
+    util::convertFromFloat(y.data(), y_half.data(), dimension);
+    util::convertToFloat(x_half.data(), x.data(), dimension);
+    util::convertToFloat(y_half.data(), y.data(), dimension);
+
+    // Expected distances, on the rounded values.
+    auto l2 = [&](const std::vector<float>& a) {
+      double sum = 0;
+      for (size_t i = 0; i < dimension; i++) {
+        sum += (double(a[i]) - y[i]) * (double(a[i]) - y[i]);
+      }
+      return static_cast<float>(sum);
+    };
+    auto ip = [&](const std::vector<float>& a) {
+      double sum = 0;
+      for (size_t i = 0; i < dimension; i++) {
+        sum += double(a[i]) * y[i];
+      }
+      return static_cast<float>(1.0 - sum);
+    };
+    float tolerance = 1e-4f * dimension;
+
+    // Checks the kernels from a float32 query and from a stored vector.
+    auto check = [&](util::DistanceFunction l2_query, util::DistanceFunction l2_data,
+                     util::DistanceFunction ip_query, util::DistanceFunction ip_data) {
+      ASSERT_NEAR(l2_query(query.data(), y_half.data(), dimension), l2(query), tolerance);
+      ASSERT_NEAR(l2_data(x_half.data(), y_half.data(), dimension), l2(x), tolerance);
+      ASSERT_NEAR(ip_query(query.data(), y_half.data(), dimension), ip(query), tolerance);
+      ASSERT_NEAR(ip_data(x_half.data(), y_half.data(), dimension), ip(x), tolerance);
+    };
+
+    using flatnav::distances::IPDistanceDispatcher;
+    using flatnav::distances::L2DistanceDispatcher;
+    check(L2DistanceDispatcher::resolve<float, T>(dimension), L2DistanceDispatcher::resolve<T, T>(dimension),
+          IPDistanceDispatcher::resolve<float, T>(dimension), IPDistanceDispatcher::resolve<T, T>(dimension));
+#if defined(BUILD_AVX2_KERNELS)
+    if (platformSupportsAvx2()) {
+      check(util::computeL2_Avx2_half<float, T>, util::computeL2_Avx2_half<T, T>,
+            util::computeIP_Avx2_half<float, T>, util::computeIP_Avx2_half<T, T>);
+    }
+#endif
+#if defined(BUILD_AVX512_KERNELS)
+    if (platformSupportsAvx512Bw()) {
+      check(util::computeL2_Avx512_half<float, T>, util::computeL2_Avx512_half<T, T>,
+            util::computeIP_Avx512_half<float, T>, util::computeIP_Avx512_half<T, T>);
+    }
+#endif
+  }
+}
+
+TEST(TestHalfPrecision, TestDistances) {
+  checkHalfPrecisionDistances<util::float16_t>();
+  checkHalfPrecisionDistances<util::bfloat16_t>();
+
+  // Asymmetric distances take a float32 query, symmetric ones two stored
+  // vectors.
+  auto distance = distances::SquaredL2Distance<DataType::float16>::create(3);
+  ASSERT_EQ(distance->dataSize(), 3 * sizeof(util::float16_t));
+  float x[3] = {1.0f, 2.0f, 3.0f};
+  float y[3] = {1.5f, 2.0f, 1.0f};
+  util::float16_t x_half[3], y_half[3];
+  distance->transformData(x_half, x);
+  distance->transformData(y_half, y);
+  ASSERT_EQ(distance->distance(x, y_half, /* asymmetric = */ true), 4.25f);
+  ASSERT_EQ(distance->distance(x_half, y_half), 4.25f);
+}
+
+// Vectors are normalized when stored and queries when prepared, so that
+// distances do not depend on the norms.
+TEST(TestCosineDistance, TestNormalization) {
+  float x[4] = {3.0f, 0.0f, 4.0f, 0.0f};
+  float y[4] = {0.0f, 2.0f, 0.0f, 0.0f};
+  float z[4] = {0.6f, 0.8f, 0.0f, 0.0f};
+  float zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+  auto distance = distances::CosineDistance<DataType::float32>::create(4);
+  float x_stored[4], y_stored[4], z_stored[4], zero_stored[4];
+  distance->transformData(x_stored, x);
+  distance->transformData(y_stored, y);
+  distance->transformData(z_stored, z);
+  distance->transformData(zero_stored, zero);
+  ASSERT_NEAR(x_stored[0], 0.6f, 1e-6);
+  ASSERT_NEAR(x_stored[2], 0.8f, 1e-6);
+
+  ASSERT_NEAR(distance->distance(x_stored, x_stored), 0.0f, 1e-6);
+  ASSERT_NEAR(distance->distance(x_stored, y_stored), 1.0f, 1e-6);
+  ASSERT_NEAR(distance->distance(x_stored, z_stored), 1.0f - 0.36f, 1e-6);
+  ASSERT_NEAR(distance->distance(x_stored, zero_stored), 1.0f, 1e-6);
+
+  std::vector<char> buffer;
+  float query[4] = {0.0f, 10.0f, 0.0f, 0.0f};
+  const void* prepared = distance->transformQuery(query, buffer);
+  ASSERT_NEAR(distance->distance(prepared, y_stored, /* asymmetric = */ true), 0.0f, 1e-6);
+  ASSERT_NEAR(distance->distance(prepared, z_stored, /* asymmetric = */ true), 0.2f, 1e-6);
+  ASSERT_EQ(query[1], 10.0f);
+
+  // Distances that do not prepare queries use them as given.
+  auto l2_distance = distances::SquaredL2Distance<DataType::float32>::create(4);
+  ASSERT_EQ(l2_distance->transformQuery(query, buffer), query);
+
+  auto half_distance = distances::CosineDistance<DataType::float16>::create(4);
+  ASSERT_EQ(half_distance->dataSize(), 4 * sizeof(util::float16_t));
+  util::float16_t z_half[4];
+  half_distance->transformData(z_half, z);
+  prepared = half_distance->transformQuery(x, buffer);
+  ASSERT_NEAR(half_distance->distance(prepared, z_half, /* asymmetric = */ true), 1.0f - 0.36f, 1e-3);
+}
+
 }  // namespace flatnav::testing
\ No newline at end of file
@@ -0,0 +1,778 @@
+#include <flatnav/build/NNDescent.h>
+#include <flatnav/distances/CosineDistance.h>
+#include <flatnav/distances/DistanceInterface.h>
+#include <flatnav/distances/SquaredL2Distance.h>
+#include <flatnav/index/Index.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <set>
+#include <thread>
+#include "gtest/gtest.h"
+
+using flatnav::Index;
+using flatnav::distances::SquaredL2Distance;
+using flatnav::util::DataType;
+
+namespace flatnav::testing {
+
+static const uint32_t INDEXED_VECTORS = 2000;
+static const uint32_t VEC_DIM = 32;
+static const uint32_t M = 16;
+static const uint32_t EF_CONSTRUCTION = 100;
+static const uint32_t EF_SEARCH = 50;
+
+using L2Index = Index<SquaredL2Distance<DataType::float32>, int>;
+
+std::vector<float> generateRandomVectors(uint32_t num_vectors, uint32_t dim, uint32_t seed = 1234) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+  std::vector<float> vectors(num_vectors * dim);
+  for (auto& value : vectors) {
+    value = distribution(generator);
+  }
+  return vectors;
+}
+
+std::unique_ptr<L2Index> buildIndex(std::vector<float>& vectors, uint32_t num_vectors) {
+  auto distance = SquaredL2Distance<DataType::float32>::create(VEC_DIM);
+  auto index = std::make_unique<L2Index>(
+      /* dist = */ std::move(distance), /* dataset_size = */ num_vectors,
+      /* max_edges_per_node = */ M);
+
+  std::vector<int> labels(num_vectors);
+  std::iota(labels.begin(), labels.end(), 0);
+  index->addBatch<float>(vectors.data(), labels, EF_CONSTRUCTION);
+  return index;
+}
+
+// Brute-force nearest neighbors: the labels of the k vectors closest to each
+// query, closest first.
+std::vector<std::vector<int>> exactNeighbors(const std::vector<float>& vectors, const std::vector<float>& queries,
+                                             uint32_t k) {
+  auto distance = SquaredL2Distance<DataType::float32>::create(VEC_DIM);
+  uint32_t num_vectors = vectors.size() / VEC_DIM;
+  std::vector<std::vector<int>> neighbors;
+  for (uint32_t query = 0; query < queries.size() / VEC_DIM; query++) {
+    std::vector<std::pair<float, int>> distances;
+    for (uint32_t label = 0; label < num_vectors; label++) {
+      distances.emplace_back(distance->distance(queries.data() + query * VEC_DIM, vectors.data() + label * VEC_DIM),
+                             label);
+    }
+    std::partial_sort(distances.begin(), distances.begin() + k, distances.end());
+    std::vector<int> nearest;
+    for (uint32_t i = 0; i < k; i++) {
+      nearest.push_back(distances[i].second);
+    }
+    neighbors.push_back(nearest);
+  }
+  return neighbors;
+}
+
+TEST(FlatnavIndexTest, TestUpdateMovesVectorToNewLocation) {
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  auto index = buildIndex(vectors, INDEXED_VECTORS);
+
+  // Move label 7 on top of the vector stored under label 1000.
+  int label = 7;
+  std::vector<float> new_vector(vectors.begin() + 1000 * VEC_DIM, vectors.begin() + 1001 * VEC_DIM);
+  index->update(new_vector.data(), label, EF_CONSTRUCTION);
+
+  auto results = index->search(new_vector.data(), /* K = */ 2, EF_SEARCH);
+  ASSERT_EQ(results.size(), 2);
+  ASSERT_NEAR(results[0].first, 0.0f, 1e-5);
+  ASSERT_NEAR(results[1].first, 0.0f, 1e-5);
+  std::set<int> found = {results[0].second, results[1].second};
+  ASSERT_TRUE(found.count(7));
+  ASSERT_TRUE(found.count(1000));
+
+  // The old location of label 7 should no longer match it exactly.
+  float* old_vector = vectors.data() + 7 * VEC_DIM;
+  auto old_results = index->search(old_vector, /* K = */ 1, EF_SEARCH);
+  ASSERT_EQ(old_results.size(), 1);
+  ASSERT_GT(old_results[0].first, 0.0f);
+
+  // Links must stay free of duplicates after the node is re-linked.
+  auto outdegree_table = index->getGraphOutdegreeTable();
+  for (const auto& links : outdegree_table) {
+    std::set<uint32_t> unique_links(links.begin(), links.end());
+    ASSERT_EQ(unique_links.size(), links.size());
+  }
+}
+
+TEST(FlatnavIndexTest, TestUpdateUnknownLabelThrows) {
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  auto index = buildIndex(vectors, INDEXED_VECTORS);
+
+  ASSERT_THROW(index->update(vectors.data(), INDEXED_VECTORS + 1, EF_CONSTRUCTION), std::invalid_argument);
+}
+
+TEST(FlatnavIndexTest, TestLabelLookup) {
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  auto index = buildIndex(vectors, INDEXED_VECTORS);
+
+  // Lookups work through the linear scan before the map is enabled.
+  ASSERT_TRUE(index->contains(42));
+  index->enableLabelLookup();
+  ASSERT_TRUE(index->labelLookupEnabled());
+
+  for (int label = 0; label < static_cast<int>(INDEXED_VECTORS); label++) {
+    ASSERT_TRUE(index->contains(label));
+    const float* stored = static_cast<const float*>(index->getVector(label));
+    ASSERT_EQ(std::memcmp(stored, vectors.data() + label * VEC_DIM, VEC_DIM * sizeof(float)), 0);
+  }
+  ASSERT_FALSE(index->contains(-1));
+  ASSERT_THROW(index->getVector(INDEXED_VECTORS), std::invalid_argument);
+
+  // The map must follow nodes when they are physically moved.
+  index->reorderRCM();
+  for (int label = 0; label < static_cast<int>(INDEXED_VECTORS); label += 97) {
+    const float* stored = static_cast<const float*>(index->getVector(label));
+    ASSERT_EQ(std::memcmp(stored, vectors.data() + label * VEC_DIM, VEC_DIM * sizeof(float)), 0);
+  }
+}
+
+TEST(FlatnavIndexTest, TestReAddedLabelLookup) {
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  auto index = std::make_unique<L2Index>(
+      /* dist = */ SquaredL2Distance<DataType::float32>::create(VEC_DIM),
+      /* dataset_size = */ INDEXED_VECTORS, /* max_edges_per_node = */ M);
+  std::vector<int> labels(INDEXED_VECTORS - 2);
+  std::iota(labels.begin(), labels.end(), 0);
+  index->addBatch<float>(vectors.data(), labels, EF_CONSTRUCTION);
+
+  // A re-added label refers to its latest vector through the linear scan, a
+  // map built afterwards and a map that sees the insert.
+  int label = 7;
+  float* second = vectors.data() + (INDEXED_VECTORS - 2) * VEC_DIM;
+  index->add(second, label, EF_CONSTRUCTION, /* num_initializations = */ 100);
+  ASSERT_EQ(std::memcmp(index->getVector(label), second, VEC_DIM * sizeof(float)), 0);
+  index->enableLabelLookup();
+  ASSERT_EQ(std::memcmp(index->getVector(label), second, VEC_DIM * sizeof(float)), 0);
+
+  float* third = vectors.data() + (INDEXED_VECTORS - 1) * VEC_DIM;
+  index->add(third, label, EF_CONSTRUCTION, /* num_initializations = */ 100);
+  ASSERT_EQ(std::memcmp(index->getVector(label), third, VEC_DIM * sizeof(float)), 0);
+}
+
+TEST(FlatnavIndexTest, TestLabelLookupDuringAdd) {
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  auto index = std::make_unique<L2Index>(
+      /* dist = */ SquaredL2Distance<DataType::float32>::create(VEC_DIM),
+      /* dataset_size = */ INDEXED_VECTORS, /* max_edges_per_node = */ M);
+  index->enableLabelLookup();
+
+  // Labels are found only once their nodes are published, with their data.
+  std::atomic<bool> done(false);
+  std::thread reader([&]() {
+    while (!done) {
+      for (int label = 0; label < static_cast<int>(INDEXED_VECTORS); label += 37) {
+        if (index->contains(label)) {
+          const float* stored = static_cast<const float*>(index->getVector(label));
+          ASSERT_EQ(std::memcmp(stored, vectors.data() + label * VEC_DIM, VEC_DIM * sizeof(float)), 0);
+        }
+      }
+    }
+  });
+  flatnav::executeInParallel(
+      /* start_index = */ 0, /* end_index = */ INDEXED_VECTORS, /* num_threads = */ 3,
+      /* function = */ [&](uint64_t row_index) {
+        int label = static_cast<int>(row_index);
+        index->add(vectors.data() + row_index * VEC_DIM, label, EF_CONSTRUCTION, 100);
+      });
+  done = true;
+  reader.join();
+  for (int label = 0; label < static_cast<int>(INDEXED_VECTORS); label++) {
+    ASSERT_TRUE(index->contains(label));
+  }
+}
+
+TEST(FlatnavIndexTest, TestSearchByLabelExcludesItem) {
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  auto index = buildIndex(vectors, INDEXED_VECTORS);
+  index->enableLabelLookup();
+
+  const int K = 10;
+  for (int label = 0; label < static_cast<int>(INDEXED_VECTORS); label += 101) {
+    auto results = index->searchByLabel(label, K, EF_SEARCH);
+    ASSERT_EQ(results.size(), K);
+
+    auto expected = index->search(vectors.data() + label * VEC_DIM, K + 1, EF_SEARCH);
+    std::set<int> expected_labels;
+    for (const auto& [distance, expected_label] : expected) {
+      expected_labels.insert(expected_label);
+    }
+    for (const auto& [distance, result_label] : results) {
+      ASSERT_NE(result_label, label);
+      ASSERT_TRUE(expected_labels.count(result_label));
+    }
+  }
+}
+
+TEST(FlatnavIndexTest, TestParallelAddPublishesAllNodes) {
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  auto index = std::make_unique<L2Index>(
+      /* dist = */ SquaredL2Distance<DataType::float32>::create(VEC_DIM),
+      /* dataset_size = */ INDEXED_VECTORS, /* max_edges_per_node = */ M);
+
+  // Drive `add` from several threads directly, since `setNumThreads` is capped
+  // by the hardware concurrency of the machine running the test.
+  flatnav::executeInParallel(
+      /* start_index = */ 0, /* end_index = */ INDEXED_VECTORS, /* num_threads = */ 4,
+      /* function = */ [&](uint64_t row_index) {
+        int label = static_cast<int>(row_index);
+        index->add(vectors.data() + row_index * VEC_DIM, label, EF_CONSTRUCTION, 100);
+      });
+  ASSERT_EQ(index->currentNumNodes(), INDEXED_VECTORS);
+
+  uint32_t found = 0;
+  for (int label = 0; label < static_cast<int>(INDEXED_VECTORS); label++) {
+    auto results = index->search(vectors.data() + label * VEC_DIM, /* K = */ 1, EF_SEARCH);
+    found += results[0].second == label;
+  }
+  ASSERT_GE(found, INDEXED_VECTORS * 0.99);
+
+  int extra_label = INDEXED_VECTORS;
+  ASSERT_THROW(index->add(vectors.data(), extra_label, EF_CONSTRUCTION, 100), std::runtime_error);
+  ASSERT_EQ(index->currentNumNodes(), INDEXED_VECTORS);
+}
+
+TEST(FlatnavIndexTest, TestAddRejectsInvalidArgumentsBeforeReserving) {
+  auto vectors = generateRandomVectors(3, VEC_DIM);
+  auto index = std::make_unique<L2Index>(
+      /* dist = */ SquaredL2Distance<DataType::float32>::create(VEC_DIM),
+      /* dataset_size = */ 3, /* max_edges_per_node = */ M);
+
+  int label = 0;
+  index->add(vectors.data(), label, EF_CONSTRUCTION, 100);
+  label = 1;
+  ASSERT_THROW(index->add(vectors.data() + VEC_DIM, label, EF_CONSTRUCTION, 0), std::invalid_argument);
+  ASSERT_FALSE(index->contains(1));
+
+  // A failed add must not leave an unpublished id that later adds wait for.
+  index->add(vectors.data() + VEC_DIM, label, EF_CONSTRUCTION, 100);
+  label = 2;
+  index->add(vectors.data() + 2 * VEC_DIM, label, EF_CONSTRUCTION, 100);
+  ASSERT_EQ(index->currentNumNodes(), 3);
+  ASSERT_EQ(index->search(vectors.data() + 2 * VEC_DIM, /* K = */ 1, EF_SEARCH)[0].second, 2);
+}
+
+TEST(FlatnavIndexTest, TestAddBulkRecall) {
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  auto queries = generateRandomVectors(100, VEC_DIM, /* seed = */ 4321);
+  const int K = 10;
+  std::vector<int> labels(INDEXED_VECTORS);
+  std::iota(labels.begin(), labels.end(), 0);
+
+  auto ground_truth = exactNeighbors(vectors, queries, K);
+
+  for (int num_passes : {1, 2}) {
+    auto index = std::make_unique<L2Index>(
+        /* dist = */ SquaredL2Distance<DataType::float32>::create(VEC_DIM),
+        /* dataset_size = */ INDEXED_VECTORS, /* max_edges_per_node = */ M);
+    index->addBulk<float>(vectors.data(), labels, EF_CONSTRUCTION, /* num_initializations = */ 100, num_passes);
+    ASSERT_EQ(index->currentNumNodes(), INDEXED_VECTORS);
+
+    uint32_t found = 0;
+    for (uint32_t query = 0; query < 100; query++) {
+      auto results = index->search(queries.data() + query * VEC_DIM, K, EF_SEARCH);
+      for (const auto& [distance, label] : results) {
+        found += std::count(ground_truth[query].begin(), ground_truth[query].end(), label);
+      }
+    }
+    ASSERT_GE(found, 100 * K * 0.9);
+
+    auto outdegree_table = index->getGraphOutdegreeTable();
+    for (const auto& links : outdegree_table) {
+      ASSERT_FALSE(links.empty());
+      std::set<uint32_t> unique_links(links.begin(), links.end());
+      ASSERT_EQ(unique_links.size(), links.size());
+    }
+  }
+}
+
+TEST(FlatnavIndexTest, TestLinkDistancesMatchGraph) {
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  uint32_t num_initial = INDEXED_VECTORS - 500;
+  std::vector<int> labels(INDEXED_VECTORS);
+  std::iota(labels.begin(), labels.end(), 0);
+  std::vector<int> initial_labels(labels.begin(), labels.begin() + num_initial);
+  std::vector<int> remaining_labels(labels.begin() + num_initial, labels.end());
+
+  std::vector<std::unique_ptr<L2Index>> indexes;
+  for (bool cache_distances : {false, true}) {
+    auto index = std::make_unique<L2Index>(
+        /* dist = */ SquaredL2Distance<DataType::float32>::create(VEC_DIM),
+        /* dataset_size = */ INDEXED_VECTORS, /* max_edges_per_node = */ M);
+    if (cache_distances) {
+      index->enableLinkDistances();
+    }
+    index->addBatch<float>(vectors.data(), initial_labels, EF_CONSTRUCTION);
+    // Nodes move when the graph is re-ordered, and the cache must follow them.
+    index->reorderRCM();
+    index->addBatch<float>(vectors.data() + num_initial * VEC_DIM, remaining_labels, EF_CONSTRUCTION);
+    indexes.push_back(std::move(index));
+  }
+
+  // Cached distances are exact, so pruning must keep the same links.
+  ASSERT_TRUE(indexes[1]->linkDistancesEnabled());
+  ASSERT_EQ(indexes[0]->getGraphOutdegreeTable(), indexes[1]->getGraphOutdegreeTable());
+
+  indexes[1]->dropLinkDistances();
+  ASSERT_EQ(indexes[1]->linkDistancesAllocatedMemory(), 0);
+}
+
+TEST(FlatnavIndexTest, TestPruningConfig) {
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  std::vector<int> labels(INDEXED_VECTORS);
+  std::iota(labels.begin(), labels.end(), 0);
+
+  auto averageDegree = [](L2Index& index) {
+    size_t num_links = 0;
+    for (const auto& links : index.getGraphOutdegreeTable()) {
+      num_links += links.size();
+    }
+    return static_cast<double>(num_links) / index.currentNumNodes();
+  };
+
+  auto reference = buildIndex(vectors, INDEXED_VECTORS);
+
+  flatnav::PruningConfig pruning;
+  pruning.alpha = 1.2f;
+  pruning.forward_degree = M;
+  auto index = std::make_unique<L2Index>(
+      /* dist = */ SquaredL2Distance<DataType::float32>::create(VEC_DIM),
+      /* dataset_size = */ INDEXED_VECTORS, /* max_edges_per_node = */ M,
+      /* collect_stats = */ false, /* data_type = */ DataType::float32,
+      /* entry_policy = */ flatnav::EntryPolicy::Strided, /* pruning = */ pruning);
+  index->addBatch<float>(vectors.data(), labels, EF_CONSTRUCTION);
+
+  // A larger alpha and forward budget keep more of the candidate links.
+  ASSERT_GT(averageDegree(*index), averageDegree(*reference));
+  for (int label = 0; label < static_cast<int>(INDEXED_VECTORS); label += 97) {
+    auto results = index->search(vectors.data() + label * VEC_DIM, /* K = */ 1, EF_SEARCH);
+    ASSERT_EQ(results[0].second, label);
+  }
+
+  // Keeping pruned connections fills every slot that has enough candidates.
+  flatnav::PruningConfig keep_pruned;
+  keep_pruned.keep_pruned = true;
+  keep_pruned.forward_degree = M;
+  index = std::make_unique<L2Index>(SquaredL2Distance<DataType::float32>::create(VEC_DIM), INDEXED_VECTORS, M,
+                                    false, DataType::float32, flatnav::EntryPolicy::Strided, keep_pruned);
+  index->addBatch<float>(vectors.data(), labels, EF_CONSTRUCTION);
+  ASSERT_EQ(averageDegree(*index), M);
+
+  flatnav::PruningConfig invalid;
+  invalid.alpha = 0.5f;
+  ASSERT_THROW(L2Index(SquaredL2Distance<DataType::float32>::create(VEC_DIM), INDEXED_VECTORS, M, false,
+                       DataType::float32, flatnav::EntryPolicy::Strided, invalid),
+               std::invalid_argument);
+  invalid.alpha = 1.0f;
+  invalid.backward_degree = M + 1;
+  ASSERT_THROW(L2Index(SquaredL2Distance<DataType::float32>::create(VEC_DIM), INDEXED_VECTORS, M, false,
+                       DataType::float32, flatnav::EntryPolicy::Strided, invalid),
+               std::invalid_argument);
+}
+
+TEST(FlatnavIndexTest, TestImportKnnGraph) {
+  const uint32_t num_vectors = 1000;
+  const uint32_t k = 32;
+  auto vectors = generateRandomVectors(num_vectors, VEC_DIM);
+
+  // Exact kNN graph, closest first, with the last column padded with -1. The
+  // closest vector to each node is the node itself.
+  auto neighbors = exactNeighbors(vectors, vectors, k + 1);
+  std::vector<int32_t> knn_graph(num_vectors * k);
+  for (uint32_t node = 0; node < num_vectors; node++) {
+    for (uint32_t j = 0; j < k; j++) {
+      knn_graph[node * k + j] = j == k - 1 ? -1 : neighbors[node][j + 1];
+    }
+  }
+
+  auto allocateIndex = [&]() {
+    auto index = std::make_unique<L2Index>(
+        /* dist = */ SquaredL2Distance<DataType::float32>::create(VEC_DIM),
+        /* dataset_size = */ num_vectors, /* max_edges_per_node = */ M);
+    for (int label = 0; label < static_cast<int>(num_vectors); label++) {
+      uint32_t node_id;
+      index->allocateNode(vectors.data() + label * VEC_DIM, label, node_id);
+    }
+    return index;
+  };
+
+  auto index = allocateIndex();
+  ASSERT_THROW(index->importKnnGraph(knn_graph.data(), num_vectors - 1, k), std::invalid_argument);
+  index->importKnnGraph(knn_graph.data(), num_vectors, k);
+  for (int label = 0; label < static_cast<int>(num_vectors); label += 7) {
+    auto results = index->search(vectors.data() + label * VEC_DIM, /* K = */ 1, EF_SEARCH);
+    ASSERT_EQ(results[0].second, label);
+  }
+
+  // Without pruning or reverse edges, every node keeps its first M neighbors.
+  auto unpruned = allocateIndex();
+  unpruned->importKnnGraph(knn_graph.data(), num_vectors, k, /* prune = */ false,
+                           /* add_reverse_edges = */ false);
+  auto outdegree_table = unpruned->getGraphOutdegreeTable();
+  for (uint32_t node = 0; node < num_vectors; node++) {
+    std::set<uint32_t> links(outdegree_table[node].begin(), outdegree_table[node].end());
+    std::set<uint32_t> expected(knn_graph.begin() + node * k, knn_graph.begin() + node * k + M);
+    ASSERT_EQ(links, expected);
+  }
+
+  // The same graph stored as a .npy file gives the same index.
+  std::string filename = "knn_graph.npy";
+  {
+    std::string header = "{'descr': '<i4', 'fortran_order': False, 'shape': (" + std::to_string(num_vectors) +
+                         ", " + std::to_string(k) + "), }";
+    header.append(64 - (10 + header.size() + 1) % 64, ' ');
+    header.push_back('\n');
+    std::ofstream stream(filename, std::ios::binary);
+    stream.write("\x93NUMPY\x01\x00", 8);
+    uint16_t header_length = header.size();
+    stream.write(reinterpret_cast<const char*>(&header_length), sizeof(header_length));
+    stream.write(header.data(), header.size());
+    stream.write(reinterpret_cast<const char*>(knn_graph.data()), knn_graph.size() * sizeof(int32_t));
+  }
+  auto from_file = allocateIndex();
+  from_file->importKnnGraph(filename);
+  std::remove(filename.c_str());
+  ASSERT_EQ(from_file->getGraphOutdegreeTable(), index->getGraphOutdegreeTable());
+}
+
+TEST(FlatnavIndexTest, TestNNDescent) {
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  auto queries = generateRandomVectors(100, VEC_DIM, /* seed = */ 4321);
+  const int K = 10;
+
+  auto ground_truth = exactNeighbors(vectors, queries, K);
+
+  auto index = std::make_unique<L2Index>(
+      /* dist = */ SquaredL2Distance<DataType::float32>::create(VEC_DIM),
+      /* dataset_size = */ INDEXED_VECTORS, /* max_edges_per_node = */ M);
+  for (int label = 0; label < static_cast<int>(INDEXED_VECTORS); label++) {
+    uint32_t node_id;
+    index->allocateNode(vectors.data() + label * VEC_DIM, label, node_id);
+  }
+
+  flatnav::build::NNDescentParameters parameters;
+  parameters.sample_rate = 0;
+  ASSERT_THROW(flatnav::build::nnDescent(*index, parameters), std::invalid_argument);
+
+  parameters.k = 2 * M;
+  parameters.sample_rate = 0.5f;
+  flatnav::build::nnDescent(*index, parameters);
+
+  uint32_t found = 0;
+  for (uint32_t query = 0; query < 100; query++) {
+    auto results = index->search(queries.data() + query * VEC_DIM, K, EF_SEARCH);
+    for (const auto& [distance, label] : results) {
+      found += std::count(ground_truth[query].begin(), ground_truth[query].end(), label);
+    }
+  }
+  ASSERT_GE(found, 100 * K * 0.9);
+}
+
+TEST(FlatnavIndexTest, TestParallelGOrder) {
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  auto index = buildIndex(vectors, INDEXED_VECTORS);
+
+  // The CSR export holds the same links as the outdegree table.
+  auto outdegree_table = index->getGraphOutdegreeTable();
+  auto graph = index->getGraphCsr();
+  ASSERT_EQ(graph.numNodes(), INDEXED_VECTORS);
+  for (uint32_t node = 0; node < INDEXED_VECTORS; node++) {
+    auto neighbors = graph.neighbors(node);
+    ASSERT_EQ(std::vector<uint32_t>(neighbors.begin(), neighbors.end()), outdegree_table[node]);
+  }
+
+  // Partitions are ordered concurrently, but the result is a permutation.
+  auto P = flatnav::util::parallelGOrder<uint32_t>(graph, /* w = */ 5, /* num_partitions = */ 4,
+                                                   /* num_threads = */ 4);
+  std::vector<uint32_t> sorted_P(P);
+  std::sort(sorted_P.begin(), sorted_P.end());
+  std::vector<uint32_t> identity(INDEXED_VECTORS);
+  std::iota(identity.begin(), identity.end(), 0);
+  ASSERT_EQ(sorted_P, identity);
+
+  index->reorderParallelGOrder(/* window_size = */ 5, /* num_partitions = */ 4);
+  for (int label = 0; label < static_cast<int>(INDEXED_VECTORS); label += 97) {
+    auto results = index->search(vectors.data() + label * VEC_DIM, /* K = */ 1, EF_SEARCH);
+    ASSERT_EQ(results[0].second, label);
+  }
+}
+
+TEST(FlatnavIndexTest, TestFrequencyReordering) {
+  // A ring 0 - 1 - 2 - 3 - 4 - 0. Node 3 is the hottest hub and is followed
+  // by its visited neighbor 2, then by hub 1. Unvisited nodes come last.
+  auto ring = flatnav::util::CsrGraph<uint32_t>::fromOutdegreeTable({{1, 4}, {0, 2}, {1, 3}, {2, 4}, {3, 0}});
+  std::vector<uint32_t> frequencies = {0, 5, 1, 9, 0};
+  auto P = flatnav::util::hubOrder<uint32_t>(ring, frequencies);
+  ASSERT_EQ(P, std::vector<uint32_t>({3, 2, 1, 0, 4}));
+
+  // Visit counts follow their nodes, so the frequency entry policy still
+  // finds every vector after reordering.
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  auto index = std::make_unique<L2Index>(
+      /* dist = */ SquaredL2Distance<DataType::float32>::create(VEC_DIM),
+      /* dataset_size = */ INDEXED_VECTORS, /* max_edges_per_node = */ M,
+      /* collect_stats = */ false, /* data_type = */ DataType::float32,
+      /* entry_policy = */ flatnav::EntryPolicy::Frequency);
+  std::vector<int> labels(INDEXED_VECTORS);
+  std::iota(labels.begin(), labels.end(), 0);
+  index->addBatch<float>(vectors.data(), labels, EF_CONSTRUCTION);
+  index->reorderByFrequency();
+  ASSERT_TRUE(index->isReordered());
+  for (int label = 0; label < static_cast<int>(INDEXED_VECTORS); label += 97) {
+    auto results = index->search(vectors.data() + label * VEC_DIM, /* K = */ 1, EF_SEARCH);
+    ASSERT_EQ(results[0].second, label);
+  }
+}
+
+TEST(FlatnavIndexTest, TestVectorSpaceReordering) {
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  auto distance = SquaredL2Distance<DataType::float32>::create(VEC_DIM);
+
+  // Mean distance between the vectors of consecutive nodes.
+  auto layoutSpread = [&](const std::vector<uint32_t>& P) {
+    std::vector<uint32_t> vector_at(INDEXED_VECTORS);
+    for (uint32_t i = 0; i < INDEXED_VECTORS; i++) {
+      vector_at[P[i]] = i;
+    }
+    double spread = 0;
+    for (uint32_t node = 1; node < INDEXED_VECTORS; node++) {
+      spread += distance->distance(vectors.data() + vector_at[node - 1] * VEC_DIM,
+                                   vectors.data() + vector_at[node] * VEC_DIM);
+    }
+    return spread / (INDEXED_VECTORS - 1);
+  };
+  std::vector<uint32_t> identity(INDEXED_VECTORS);
+  std::iota(identity.begin(), identity.end(), 0);
+
+  for (const std::string method : {"zorder", "kmeans"}) {
+    auto index = buildIndex(vectors, INDEXED_VECTORS);
+    index->doGraphReordering({method});
+    ASSERT_TRUE(index->isReordered());
+    ASSERT_LT(layoutSpread(index->permutation()), 0.9 * layoutSpread(identity)) << method;
+
+    for (int label = 0; label < static_cast<int>(INDEXED_VECTORS); label += 97) {
+      auto results = index->search(vectors.data() + label * VEC_DIM, /* K = */ 1, EF_SEARCH);
+      ASSERT_EQ(results[0].second, label) << method;
+    }
+  }
+}
+
+TEST(FlatnavIndexTest, TestZOrderSingleProjection) {
+  // With one projection of 1-D vectors, the Z-order is the order of the
+  // values, in one direction or the other, including the largest one.
+  const uint32_t num_nodes = 1000;
+  std::vector<float> values(num_nodes);
+  std::iota(values.begin(), values.end(), 0.0f);
+  std::shuffle(values.begin(), values.end(), std::mt19937(1234));
+  auto Pinv = flatnav::util::zOrder<uint32_t>(
+      num_nodes, /* dim = */ 1, [&](uint32_t node, float* destination) { *destination = values[node]; },
+      /* num_threads = */ 1, /* num_projections = */ 1);
+
+  std::vector<float> ordered(num_nodes);
+  for (uint32_t node = 0; node < num_nodes; node++) {
+    ordered[Pinv[node]] = values[node];
+  }
+  ASSERT_TRUE(std::is_sorted(ordered.begin(), ordered.end()) ||
+              std::is_sorted(ordered.rbegin(), ordered.rend()));
+}
+
+TEST(FlatnavIndexTest, TestParallelRCM) {
+  // A random graph large enough for levels to be expanded in parallel.
+  const uint32_t num_nodes = 100000;
+  std::mt19937 generator(1234);
+  std::uniform_int_distribution<uint32_t> distribution(0, num_nodes - 1);
+  std::vector<std::vector<uint32_t>> outdegree_table(num_nodes);
+  for (auto& links : outdegree_table) {
+    for (int i = 0; i < 8; i++) {
+      links.push_back(distribution(generator));
+    }
+  }
+
+  auto graph = flatnav::util::CsrGraph<uint32_t>::fromOutdegreeTable(outdegree_table);
+  auto P = flatnav::util::rcmOrder<uint32_t>(graph, /* num_threads = */ 1);
+  std::vector<uint32_t> sorted_P(P);
+  std::sort(sorted_P.begin(), sorted_P.end());
+  std::vector<uint32_t> identity(num_nodes);
+  std::iota(identity.begin(), identity.end(), 0);
+  ASSERT_EQ(sorted_P, identity);
+
+  // The parallel BFS gives the same order as the sequential one.
+  ASSERT_EQ(flatnav::util::rcmOrder<uint32_t>(graph, /* num_threads = */ 4), P);
+}
+
+TEST(FlatnavIndexTest, TestGraphStats) {
+  // Cycle 0 -> 1 -> 2 -> 0, cycle 3 <-> 4 and 5 -> 0, with 3 slots per node.
+  auto graph = flatnav::util::CsrGraph<uint32_t>::fromOutdegreeTable({{1}, {2}, {0}, {4}, {3}, {0}});
+  auto stats = flatnav::util::graphStats<uint32_t>(graph, /* max_edges_per_node = */ 3,
+                                                   /* entry_nodes = */ {0}, /* num_threads = */ 2);
+  ASSERT_EQ(stats.num_edges, 6);
+  ASSERT_DOUBLE_EQ(stats.unused_link_fraction, 2.0 / 3.0);
+  ASSERT_EQ(stats.out_degree_histogram, std::vector<size_t>({0, 6}));
+  ASSERT_EQ(stats.in_degree_histogram, std::vector<size_t>({1, 4, 1}));
+  ASSERT_EQ(stats.num_strongly_connected_components, 3);
+  ASSERT_EQ(stats.largest_strongly_connected_component, 3);
+  ASSERT_EQ(stats.num_reachable_nodes, 3);
+  ASSERT_DOUBLE_EQ(stats.top_percent_in_edge_fraction, 2.0 / 6.0);
+
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  auto index = buildIndex(vectors, INDEXED_VECTORS);
+  auto index_stats = index->graphStats();
+  ASSERT_EQ(index_stats.num_nodes, INDEXED_VECTORS);
+  size_t num_edges = 0;
+  for (size_t degree = 0; degree < index_stats.out_degree_histogram.size(); degree++) {
+    num_edges += degree * index_stats.out_degree_histogram[degree];
+  }
+  ASSERT_EQ(num_edges, index_stats.num_edges);
+  ASSERT_EQ(index_stats.num_reachable_nodes, INDEXED_VECTORS);
+  ASSERT_GT(index_stats.in_degree_skewness, 0);
+}
+
+TEST(FlatnavIndexTest, TestRepairConnectivity) {
+  const uint32_t num_vectors = 1000;
+  const uint32_t k = 4;
+  auto vectors = generateRandomVectors(num_vectors, VEC_DIM);
+
+  // A directed 4-NN graph without reverse edges leaves many nodes with no
+  // in-links.
+  auto neighbors = exactNeighbors(vectors, vectors, k + 1);
+  std::vector<int32_t> knn_graph(num_vectors * k);
+  for (uint32_t node = 0; node < num_vectors; node++) {
+    for (uint32_t j = 0; j < k; j++) {
+      knn_graph[node * k + j] = neighbors[node][j + 1];
+    }
+  }
+  auto index = std::make_unique<L2Index>(
+      /* dist = */ SquaredL2Distance<DataType::float32>::create(VEC_DIM),
+      /* dataset_size = */ num_vectors, /* max_edges_per_node = */ M);
+  for (int label = 0; label < static_cast<int>(num_vectors); label++) {
+    uint32_t node_id;
+    index->allocateNode(vectors.data() + label * VEC_DIM, label, node_id);
+  }
+  index->importKnnGraph(knn_graph.data(), num_vectors, k, /* prune = */ false, /* add_reverse_edges = */ false);
+  auto stats = index->graphStats();
+  ASSERT_GT(stats.in_degree_histogram[0], 0);
+  ASSERT_LT(stats.num_reachable_nodes, num_vectors);
+
+  ASSERT_GT(index->repairConnectivity(), 0);
+  stats = index->graphStats();
+  ASSERT_EQ(stats.in_degree_histogram[0], 0);
+  ASSERT_EQ(stats.num_reachable_nodes, num_vectors);
+  ASSERT_EQ(index->repairConnectivity(), 0);
+}
+
+template <DataType data_type>
+void checkHalfPrecisionIndex() {
+  using HalfL2Index = Index<SquaredL2Distance<data_type>, int>;
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  auto index = std::make_unique<HalfL2Index>(
+      /* dist = */ SquaredL2Distance<data_type>::create(VEC_DIM),
+      /* dataset_size = */ INDEXED_VECTORS, /* max_edges_per_node = */ M);
+  ASSERT_EQ(index->nodeSizeBytes(), VEC_DIM * 2 + M * sizeof(uint32_t) + sizeof(int));
+
+  // Vectors are added as float32. The relinking pass searches with the
+  // stored vectors, which must be decoded first.
+  std::vector<int> labels(INDEXED_VECTORS);
+  std::iota(labels.begin(), labels.end(), 0);
+  index->template addBulk<float>(vectors.data(), labels, EF_CONSTRUCTION, /* num_initializations = */ 100,
+                                 /* num_passes = */ 2);
+  index->enableLabelLookup();
+
+  for (int label = 0; label < static_cast<int>(INDEXED_VECTORS); label += 97) {
+    auto results = index->search(vectors.data() + label * VEC_DIM, /* K = */ 1, EF_SEARCH);
+    ASSERT_EQ(results[0].second, label);
+    ASSERT_NEAR(results[0].first, 0.0f, 1e-3);
+
+    // The stored vector is rounded, so the order of near ties can change.
+    auto neighbors = index->searchByLabel(label, /* K = */ 5, EF_SEARCH);
+    auto expected = index->search(vectors.data() + label * VEC_DIM, /* K = */ 10, EF_SEARCH);
+    std::set<int> expected_labels;
+    for (const auto& [distance, expected_label] : expected) {
+      expected_labels.insert(expected_label);
+    }
+    ASSERT_EQ(neighbors.size(), 5);
+    for (const auto& [distance, neighbor_label] : neighbors) {
+      ASSERT_NE(neighbor_label, label);
+      ASSERT_TRUE(expected_labels.count(neighbor_label));
+    }
+  }
+
+  std::string filename = "half_precision_index.bin";
+  index->saveIndex(filename);
+  auto loaded = HalfL2Index::loadIndex(filename);
+  auto results = loaded->search(vectors.data(), /* K = */ 1, EF_SEARCH);
+  ASSERT_EQ(results[0].second, 0);
+  std::remove(filename.c_str());
+}
+
+TEST(FlatnavIndexTest, TestHalfPrecisionStorage) {
+  checkHalfPrecisionIndex<DataType::float16>();
+  checkHalfPrecisionIndex<DataType::bfloat16>();
+}
+
+TEST(FlatnavIndexTest, TestCosineIndex) {
+  using CosineIndex = Index<flatnav::distances::CosineDistance<DataType::float32>, int>;
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  for (auto& value : vectors) {
+    value -= 0.5f;
+  }
+  auto index = std::make_unique<CosineIndex>(
+      /* dist = */ flatnav::distances::CosineDistance<DataType::float32>::create(VEC_DIM),
+      /* dataset_size = */ INDEXED_VECTORS, /* max_edges_per_node = */ M);
+  std::vector<int> labels(INDEXED_VECTORS);
+  std::iota(labels.begin(), labels.end(), 0);
+  index->addBatch<float>(vectors.data(), labels, EF_CONSTRUCTION);
+
+  // Scaled vectors are at cosine distance 0 from the stored ones.
+  for (int label = 0; label < static_cast<int>(INDEXED_VECTORS); label += 97) {
+    std::vector<float> query(vectors.begin() + label * VEC_DIM, vectors.begin() + (label + 1) * VEC_DIM);
+    for (auto& value : query) {
+      value *= 7.0f;
+    }
+    auto results = index->search(query.data(), /* K = */ 2, EF_SEARCH);
+    ASSERT_EQ(results[0].second, label);
+    ASSERT_NEAR(results[0].first, 0.0f, 1e-5);
+    ASSERT_GT(results[1].first, 0.0f);
+    ASSERT_LE(results[1].first, 2.0f);
+  }
+}
+
+TEST(FlatnavIndexTest, TestWideNodeIds) {
+  using WideL2Index = Index<SquaredL2Distance<DataType::float32>, int, uint64_t>;
+  auto vectors = generateRandomVectors(INDEXED_VECTORS, VEC_DIM);
+  auto index = std::make_unique<WideL2Index>(
+      /* dist = */ SquaredL2Distance<DataType::float32>::create(VEC_DIM),
+      /* dataset_size = */ INDEXED_VECTORS, /* max_edges_per_node = */ M);
+  ASSERT_EQ(index->nodeSizeBytes(), VEC_DIM * sizeof(float) + M * sizeof(uint64_t) + sizeof(int));
+
+  std::vector<int> labels(INDEXED_VECTORS);
+  std::iota(labels.begin(), labels.end(), 0);
+  index->addBatch<float>(vectors.data(), labels, EF_CONSTRUCTION);
+  index->reorderGOrder();
+
+  for (int label = 0; label < static_cast<int>(INDEXED_VECTORS); label += 97) {
+    auto results = index->search(vectors.data() + label * VEC_DIM, /* K = */ 1, EF_SEARCH);
+    ASSERT_EQ(results[0].second, label);
+  }
+
+  std::string filename = "wide_node_ids_index.bin";
+  index->saveIndex(filename);
+  auto loaded = WideL2Index::loadIndex(filename);
+  ASSERT_EQ(loaded->currentNumNodes(), INDEXED_VECTORS);
+  auto results = loaded->search(vectors.data(), /* K = */ 1, EF_SEARCH);
+  ASSERT_EQ(results[0].second, 0);
+
+  // The links of a 64-bit index cannot be read back with 32-bit node ids.
+  ASSERT_THROW(L2Index::loadIndex(filename), std::runtime_error);
+  std::remove(filename.c_str());
+}
+
+}  // namespace flatnav::testing
@@ -175,4 +175,42 @@ TEST(FlatnavSerializationTest, TestInnerProductInt8IndexSerialization) {
   EXPECT_EQ(std::remove(save_file.c_str()), 0);
 }
 
-}  // namespace flatnav::testing
\ No newline at end of file
+TEST(FlatnavSerializationTest, TestReorderingPermutationSerialization) {
+  const uint32_t num_vectors = 2000;
+  const uint32_t dim = 32;
+  auto vectors = generateRandomVectors<float>(num_vectors, dim);
+  std::string save_file = "reordered_index.bin";
+
+  auto index = std::make_unique<Index<SquaredL2Distance<>, int>>(
+      /* dist = */ std::make_unique<SquaredL2Distance<>>(dim), /* dataset_size = */ num_vectors,
+      /* max_edges = */ 16);
+  std::vector<int> labels(num_vectors);
+  std::iota(labels.begin(), labels.end(), 0);
+  index->addBatch<float>(vectors.data(), labels, /* ef_construction = */ 100);
+  ASSERT_FALSE(index->isReordered());
+
+  // The recorded permutation is the composition of both reorderings.
+  auto original_table = index->getGraphOutdegreeTable();
+  index->doGraphReordering({"rcm", "gorder"});
+  ASSERT_TRUE(index->isReordered());
+  const auto& P = index->permutation();
+  ASSERT_EQ(P.size(), num_vectors);
+  auto reordered_table = index->getGraphOutdegreeTable();
+  for (uint32_t node = 0; node < num_vectors; node++) {
+    std::vector<uint32_t> expected;
+    for (uint32_t neighbor : original_table[node]) {
+      expected.push_back(P[neighbor]);
+    }
+    ASSERT_EQ(reordered_table[P[node]], expected);
+  }
+
+  index->saveIndex(/* filename = */ save_file);
+  auto new_index = Index<SquaredL2Distance<>, int>::loadIndex(/* filename = */ save_file);
+  ASSERT_TRUE(new_index->isReordered());
+  ASSERT_EQ(new_index->permutation(), P);
+  ASSERT_EQ(new_index->getGraphOutdegreeTable(), reordered_table);
+
+  EXPECT_EQ(std::remove(save_file.c_str()), 0);
+}
+
+}  // namespace flatnav::testing
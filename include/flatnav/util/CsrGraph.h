@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace flatnav::util {
+
+/**
+ * @brief A directed graph in compressed sparse row (CSR) form: the out-links
+ * of node n are targets[offsets[n]], ..., targets[offsets[n + 1] - 1]. The
+ * two flat arrays replace the one heap allocation per node of an outdegree
+ * table (std::vector<std::vector<node_id_t>>).
+ */
+template <typename node_id_t>
+struct CsrGraph {
+  // num_nodes + 1 entries, starting at 0.
+  std::vector<uint64_t> offsets;
+  std::vector<node_id_t> targets;
+
+  // The out-links of one node, usable in range-based for loops.
+  struct NeighborRange {
+    const node_id_t* first;
+    const node_id_t* last;
+
+    const node_id_t* begin() const { return first; }
+    const node_id_t* end() const { return last; }
+    size_t size() const { return last - first; }
+  };
+
+  CsrGraph() : offsets(1, 0) {}
+
+  inline size_t numNodes() const { return offsets.size() - 1; }
+  inline size_t numEdges() const { return targets.size(); }
+  inline size_t degree(size_t node) const { return offsets[node + 1] - offsets[node]; }
+  inline NeighborRange neighbors(size_t node) const {
+    return {targets.data() + offsets[node], targets.data() + offsets[node + 1]};
+  }
+
+  static CsrGraph fromOutdegreeTable(const std::vector<std::vector<node_id_t>>& outdegree_table) {
+    CsrGraph graph;
+    graph.offsets.resize(outdegree_table.size() + 1);
+    for (size_t node = 0; node < outdegree_table.size(); node++) {
+      graph.offsets[node + 1] = graph.offsets[node] + outdegree_table[node].size();
+    }
+    graph.targets.reserve(graph.offsets.back());
+    for (const auto& links : outdegree_table) {
+      graph.targets.insert(graph.targets.end(), links.begin(), links.end());
+    }
+    return graph;
+  }
+
+  // The graph with every edge reversed, i.e. the in-links of every node. The
+  // in-links of a node are listed in increasing source order.
+  CsrGraph transpose() const {
+    CsrGraph reversed;
+    reversed.offsets.assign(numNodes() + 1, 0);
+    for (node_id_t target : targets) {
+      reversed.offsets[target + 1]++;
+    }
+    for (size_t node = 0; node < numNodes(); node++) {
+      reversed.offsets[node + 1] += reversed.offsets[node];
+    }
+    std::vector<uint64_t> positions(reversed.offsets.begin(), reversed.offsets.end() - 1);
+    reversed.targets.resize(targets.size());
+    for (size_t node = 0; node < numNodes(); node++) {
+      for (node_id_t target : neighbors(node)) {
+        reversed.targets[positions[target]++] = node;
+      }
+    }
+    return reversed;
+  }
+};
+
+}  // namespace flatnav::util
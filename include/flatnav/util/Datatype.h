@@ -1,12 +1,17 @@
 #pragma once
 
+#include <flatnav/util/HalfPrecision.h>
+#include <cstddef>
 #include <cstdint>
+#include <string_view>
+#include <utility>
 
 namespace flatnav::util {
 
 /**
  * @brief Enum class for data types
- * We currently support indexes of type float32, uint8 and int8.
+ * We currently support indexes of type float32, float16, bfloat16, uint8 and
+ * int8. New types go before `undefined`, since indexes serialize the value.
  */
 enum class DataType {
   uint8,    /** Unsigned 8-bit integer */
@@ -20,6 +25,7 @@ enum class DataType {
   float16,  /** 16-bit floating-point number */
   float32,  /** 32-bit floating-point number */
   float64,  /** 64-bit floating-point number */
+  bfloat16, /** 16-bit brain floating-point number */
   undefined /** Undefined data type */
 };
 
@@ -50,6 +56,8 @@ inline constexpr const char* name(DataType data_type) {
       return "float32";
     case DataType::float64:
       return "float64";
+    case DataType::bfloat16:
+      return "bfloat16";
     default:
       return "undefined";
   }
@@ -81,6 +89,8 @@ inline constexpr DataType type(const std::string_view& data_type) {
     return DataType::float32;
   } else if (data_type == "float64") {
     return DataType::float64;
+  } else if (data_type == "bfloat16") {
+    return DataType::bfloat16;
   } else {
     return DataType::undefined;
   }
@@ -108,11 +118,13 @@ inline constexpr size_t size(DataType data_type) {
     case DataType::int64:
       return sizeof(int64_t);
     case DataType::float16:
-      return sizeof(float) / 2;
+      return sizeof(float16_t);
     case DataType::float32:
       return sizeof(float);
     case DataType::float64:
       return sizeof(double);
+    case DataType::bfloat16:
+      return sizeof(bfloat16_t);
     default:
       return 0;
   }
@@ -135,6 +147,22 @@ template <>
 struct type_for_data_type<DataType::uint8> {
   using type = uint8_t;
 };
+template <>
+struct type_for_data_type<DataType::float16> {
+  using type = float16_t;
+};
+template <>
+struct type_for_data_type<DataType::bfloat16> {
+  using type = bfloat16_t;
+};
+
+/**
+ * @brief Whether vectors of this data type are stored in 16-bit floats. Such
+ * vectors are added and queried as float32 and converted by the distance.
+ */
+inline constexpr bool isHalfPrecision(DataType data_type) {
+  return data_type == DataType::float16 || data_type == DataType::bfloat16;
+}
 
 /**
  * @brief Template metaprogramming to allow compile-time distance dispatching
@@ -1,111 +1,131 @@
 #pragma once
 
 #include <algorithm>
-#include <climits>
 #include <cstdlib>
 #include <iostream>
-#include <unordered_map>
+#include <limits>
 #include <utility>
 #include <vector>
 
 namespace flatnav::util {
 
+/**
+ * @brief Max-priority queue over node ids for Gorder. Priorities start at 0
+ * and only move by one, so the queue is a bucket queue (the "unit heap" of the
+ * Gorder paper): every priority has an intrusive doubly-linked list of the
+ * nodes with that priority, stored in flat arrays indexed by node id. This
+ * makes `increment` and `decrement` O(1). `pop` scans down from the highest
+ * non-empty bucket, which is amortized O(1) because the maximum priority only
+ * grows by one per increment.
+ */
 template <typename node_id_t>
 class GorderPriorityQueue {
+  static constexpr node_id_t NONE = std::numeric_limits<node_id_t>::max();
+
+  // Per node: its priority, or -1 once it is popped (or if it was never in the
+  // queue), and its neighbors in the list of its bucket.
+  std::vector<int> _priority;
+  std::vector<node_id_t> _prev;
+  std::vector<node_id_t> _next;
+  // First node of every bucket.
+  std::vector<node_id_t> _bucket_heads;
+  // No bucket above this one is non-empty.
+  int _max_priority;
+  size_t _size;
+
+  inline void link(node_id_t key) {
+    int priority = _priority[key];
+    if (static_cast<size_t>(priority) >= _bucket_heads.size()) {
+      _bucket_heads.resize(priority + 1, NONE);
+    }
+    node_id_t head = _bucket_heads[priority];
+    _prev[key] = NONE;
+    _next[key] = head;
+    if (head != NONE) {
+      _prev[head] = key;
+    }
+    _bucket_heads[priority] = key;
+    _max_priority = std::max(_max_priority, priority);
+  }
 
-  typedef std::unordered_map<node_id_t, int> map_t;
-
-  struct Node {
-    node_id_t key;
-    int priority;
-  };
-
-  std::vector<Node> _list;
-  map_t _index_table;  // map: key -> index in _list
+  inline void unlink(node_id_t key) {
+    if (_prev[key] != NONE) {
+      _next[_prev[key]] = _next[key];
+    } else {
+      _bucket_heads[_priority[key]] = _next[key];
+    }
+    if (_next[key] != NONE) {
+      _prev[_next[key]] = _prev[key];
+    }
+  }
 
-  inline void swap(int i, int j) {
-    Node tmp = _list[i];
-    _list[i] = _list[j];
-    _list[j] = tmp;
-    _index_table[_list[i].key] = i;
-    _index_table[_list[j].key] = j;
+  inline bool contains(node_id_t key) const {
+    return static_cast<size_t>(key) < _priority.size() && _priority[key] >= 0;
   }
 
  public:
-  GorderPriorityQueue(const std::vector<node_id_t>& nodes) {
-    for (int i = 0; i < nodes.size(); i++) {
-      _list.push_back({nodes[i], 0});
-      _index_table[nodes[i]] = i;
+  GorderPriorityQueue(const std::vector<node_id_t>& nodes) : _max_priority(0), _size(0) {
+    node_id_t max_key = nodes.empty() ? 0 : *std::max_element(nodes.begin(), nodes.end());
+    _priority.assign(nodes.empty() ? 0 : static_cast<size_t>(max_key) + 1, -1);
+    _prev.resize(_priority.size());
+    _next.resize(_priority.size());
+    for (node_id_t key : nodes) {
+      if (_priority[key] < 0) {
+        _priority[key] = 0;
+        link(key);
+        _size++;
+      }
     }
   }
 
-  GorderPriorityQueue(size_t N) {
-    for (unsigned int i = 0; i < N; i++) {
-      _list.push_back({i, 0});
-      _index_table[i] = i;
+  GorderPriorityQueue(size_t N) : _priority(N, 0), _prev(N), _next(N), _max_priority(0), _size(N) {
+    for (size_t i = 0; i < N; i++) {
+      link(static_cast<node_id_t>(i));
     }
   }
 
   void print() {
-    for (int i = 0; i < _list.size(); i++) {
-      std::cout << "(" << _list[i].key << ":" << _list[i].priority << ")"
-                << " ";
+    for (int priority = _max_priority; priority >= 0; priority--) {
+      for (node_id_t key = _bucket_heads[priority]; key != NONE; key = _next[key]) {
+        std::cout << "(" << key << ":" << priority << ")"
+                  << " ";
+      }
     }
     std::cout << std::endl;
   }
 
-  static bool compare(const Node& a, const Node& b) { return (a.priority < b.priority); }
-
   void increment(node_id_t key) {
-    typename map_t::const_iterator i = _index_table.find(key);
-    if (i == _index_table.end()) {
+    if (!contains(key)) {
       return;
     }
-    // int new_index = _list.size()-1;
-    // while((new_index > 0) && (_list[new_index].priority >
-    // _list[i->second].priority)){ 	new_index--;
-    // }
-
-    auto it = std::upper_bound(_list.begin(), _list.end(), _list[i->second], compare);
-    size_t new_index = it - _list.begin() - 1;  // possible bug
-    // new_index points to the right-most element with same priority as key
-    // i.e. priority equal to "_list[i->second].priority" (i.e. the current
-    // priority)
-    swap(i->second, new_index);
-    _list[new_index].priority++;
+    unlink(key);
+    _priority[key]++;
+    link(key);
   }
 
+  // Priorities never drop below zero; decrementing a node with priority zero
+  // has no effect.
   void decrement(node_id_t key) {
-    typename map_t::const_iterator i = _index_table.find(key);
-    if (i == _index_table.end()) {
+    if (!contains(key) || _priority[key] == 0) {
       return;
     }
-    // int new_index = _list.size()-1;
-    // while((new_index > 0) && (_list[new_index].priority >=
-    // _list[i->second].priority)){ 	new_index--;
-    // }
-    // new_index++;
-    // i shoudl do this better but am pressed for time now
-    auto it = std::lower_bound(_list.begin(), _list.end(), _list[i->second], compare);
-    size_t new_index = it - _list.begin();  // POSSIBLE BUG
-    // while((new_index > _list.size()) && (_list[new_index].priority ==
-    // _list[i->second].priority)){ 	new_index++;
-    // }
-    // new_index--;
-    // new_index points to the right-most element with same priority as key
-
-    swap(i->second, new_index);
-    _list[new_index].priority--;
+    unlink(key);
+    _priority[key]--;
+    link(key);
   }
 
   node_id_t pop() {
-    Node max = _list.back();
-    _list.pop_back();
-    _index_table.erase(max.key);
-    return max.key;
+    while (_bucket_heads[_max_priority] == NONE) {
+      _max_priority--;
+    }
+    node_id_t max = _bucket_heads[_max_priority];
+    unlink(max);
+    _priority[max] = -1;
+    _size--;
+    return max;
   }
 
-  size_t size() { return _list.size(); }
+  size_t size() { return _size; }
 };
 
-}  // namespace flatnav::util
\ No newline at end of file
+}  // namespace flatnav::util
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <flatnav/util/CsrGraph.h>
+#include <flatnav/util/Reordering.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace flatnav::util {
+
+// Diagnostics of an index graph, see `graphStats`.
+struct GraphStats {
+  size_t num_nodes = 0;
+  // Links that point to another node. Self-loops mark unused slots and are
+  // not counted.
+  size_t num_edges = 0;
+  // Fraction of the num_nodes * M link slots that are unused.
+  double unused_link_fraction = 0;
+
+  // out_degree_histogram[d] (in_degree_histogram[d]) is the number of nodes
+  // with d out-links (in-links).
+  std::vector<size_t> out_degree_histogram;
+  std::vector<size_t> in_degree_histogram;
+
+  size_t num_strongly_connected_components = 0;
+  size_t largest_strongly_connected_component = 0;
+
+  // Nodes that a search can reach from at least one of the entry nodes. The
+  // others can never be returned.
+  size_t num_entry_nodes = 0;
+  size_t num_reachable_nodes = 0;
+
+  // Hubness, from the in-degree (k-occurrence) distribution: its skewness,
+  // and the fraction of all edges that point into the 1% of nodes with the
+  // highest in-degree. Large values mean that a few hubs attract most links.
+  double in_degree_skewness = 0;
+  double top_percent_in_edge_fraction = 0;
+};
+
+/**
+ * Returns the number of links into every node of the graph (its
+ * k-occurrence), counted on `num_threads` threads.
+ */
+template <typename node_id_t>
+std::vector<uint32_t> inDegrees(const CsrGraph<node_id_t>& graph, uint32_t num_threads = 1) {
+  std::vector<std::atomic<uint32_t>> counts(graph.numNodes());
+  parallelRange(0, graph.numNodes(), num_threads, [&](uint64_t node) {
+    for (node_id_t target : graph.neighbors(node)) {
+      counts[target].fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+  return std::vector<uint32_t>(counts.begin(), counts.end());
+}
+
+/**
+ * Returns a flag per node that is 1 if the node can be reached from one of
+ * `entry_nodes`. Levels of the BFS are expanded on `num_threads` threads; a
+ * node joins the next frontier once, when a thread first marks it.
+ */
+template <typename node_id_t>
+std::vector<uint8_t> reachableNodes(const CsrGraph<node_id_t>& graph, const std::vector<node_id_t>& entry_nodes,
+                                    uint32_t num_threads = 1) {
+  size_t num_nodes = graph.numNodes();
+  std::vector<std::atomic<uint8_t>> reached(num_nodes);
+  std::vector<node_id_t> frontier;
+  for (node_id_t entry : entry_nodes) {
+    if (entry < num_nodes && !reached[entry].exchange(1)) {
+      frontier.push_back(entry);
+    }
+  }
+  std::vector<node_id_t> next_frontier(num_nodes);
+  while (!frontier.empty()) {
+    std::atomic<size_t> next_size(0);
+    parallelRange(0, frontier.size(), num_threads, [&](uint64_t i) {
+      for (node_id_t child : graph.neighbors(frontier[i])) {
+        if (!reached[child].load(std::memory_order_relaxed) && !reached[child].exchange(1)) {
+          next_frontier[next_size.fetch_add(1, std::memory_order_relaxed)] = child;
+        }
+      }
+    });
+    frontier.assign(next_frontier.begin(), next_frontier.begin() + next_size.load());
+  }
+  return std::vector<uint8_t>(reached.begin(), reached.end());
+}
+
+/**
+ * Computes the `GraphStats` of a graph whose nodes have `max_edges_per_node`
+ * link slots, with searches starting from `entry_nodes`. Degrees and the
+ * reachability search run on `num_threads` threads. Strongly connected
+ * components are found with an iterative Tarjan's algorithm on the calling
+ * thread, which is linear in the size of the graph.
+ */
+template <typename node_id_t>
+GraphStats graphStats(const CsrGraph<node_id_t>& graph, size_t max_edges_per_node,
+                      const std::vector<node_id_t>& entry_nodes, uint32_t num_threads = 1) {
+  static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+  size_t num_nodes = graph.numNodes();
+
+  GraphStats stats;
+  stats.num_nodes = num_nodes;
+  stats.num_edges = graph.numEdges();
+  if (num_nodes == 0) {
+    return stats;
+  }
+  stats.unused_link_fraction = 1.0 - static_cast<double>(stats.num_edges) / (num_nodes * max_edges_per_node);
+
+  // Degrees.
+  std::vector<uint32_t> in_degrees = inDegrees(graph, num_threads);
+  size_t max_out_degree = 0;
+  size_t max_in_degree = 0;
+  for (size_t node = 0; node < num_nodes; node++) {
+    max_out_degree = std::max(max_out_degree, graph.degree(node));
+    max_in_degree = std::max<size_t>(max_in_degree, in_degrees[node]);
+  }
+  stats.out_degree_histogram.assign(max_out_degree + 1, 0);
+  stats.in_degree_histogram.assign(max_in_degree + 1, 0);
+  for (size_t node = 0; node < num_nodes; node++) {
+    stats.out_degree_histogram[graph.degree(node)]++;
+    stats.in_degree_histogram[in_degrees[node]]++;
+  }
+
+  // Hubness.
+  double mean = static_cast<double>(stats.num_edges) / num_nodes;
+  double second_moment = 0;
+  double third_moment = 0;
+  for (size_t degree = 0; degree <= max_in_degree; degree++) {
+    double deviation = degree - mean;
+    second_moment += stats.in_degree_histogram[degree] * deviation * deviation;
+    third_moment += stats.in_degree_histogram[degree] * deviation * deviation * deviation;
+  }
+  second_moment /= num_nodes;
+  third_moment /= num_nodes;
+  if (second_moment > 0) {
+    stats.in_degree_skewness = third_moment / std::pow(second_moment, 1.5);
+  }
+  size_t num_top_nodes = std::max<size_t>(num_nodes / 100, 1);
+  size_t top_in_edges = 0;
+  for (size_t degree = max_in_degree + 1; degree-- > 0 && num_top_nodes > 0;) {
+    size_t count = std::min(stats.in_degree_histogram[degree], num_top_nodes);
+    top_in_edges += count * degree;
+    num_top_nodes -= count;
+  }
+  if (stats.num_edges > 0) {
+    stats.top_percent_in_edge_fraction = static_cast<double>(top_in_edges) / stats.num_edges;
+  }
+
+  std::vector<uint8_t> reached = reachableNodes(graph, entry_nodes, num_threads);
+  std::vector<node_id_t> distinct_entry_nodes(entry_nodes);
+  std::sort(distinct_entry_nodes.begin(), distinct_entry_nodes.end());
+  distinct_entry_nodes.erase(std::unique(distinct_entry_nodes.begin(), distinct_entry_nodes.end()),
+                             distinct_entry_nodes.end());
+  stats.num_entry_nodes = std::count_if(distinct_entry_nodes.begin(), distinct_entry_nodes.end(),
+                                        [&](node_id_t entry) { return entry < num_nodes; });
+  stats.num_reachable_nodes = std::count(reached.begin(), reached.end(), 1);
+
+  // Strongly connected components (Tarjan). The call stack is kept as
+  // (node, next link offset) pairs.
+  std::vector<size_t> index(num_nodes, NONE);
+  std::vector<size_t> low_link(num_nodes);
+  std::vector<uint8_t> on_stack(num_nodes, 0);
+  std::vector<node_id_t> component_stack;
+  std::vector<std::pair<node_id_t, uint64_t>> call_stack;
+  size_t next_index = 0;
+  for (size_t root = 0; root < num_nodes; root++) {
+    if (index[root] != NONE) {
+      continue;
+    }
+    call_stack.push_back({static_cast<node_id_t>(root), graph.offsets[root]});
+    index[root] = low_link[root] = next_index++;
+    component_stack.push_back(root);
+    on_stack[root] = 1;
+
+    while (!call_stack.empty()) {
+      auto& [node, link] = call_stack.back();
+      if (link < graph.offsets[node + 1]) {
+        node_id_t child = graph.targets[link++];
+        if (index[child] == NONE) {
+          index[child] = low_link[child] = next_index++;
+          component_stack.push_back(child);
+          on_stack[child] = 1;
+          call_stack.push_back({child, graph.offsets[child]});
+        } else if (on_stack[child]) {
+          low_link[node] = std::min(low_link[node], index[child]);
+        }
+        continue;
+      }
+
+      node_id_t finished = node;
+      call_stack.pop_back();
+      if (!call_stack.empty()) {
+        node_id_t parent = call_stack.back().first;
+        low_link[parent] = std::min(low_link[parent], low_link[finished]);
+      }
+      if (low_link[finished] == index[finished]) {
+        size_t component_size = 0;
+        node_id_t member;
+        do {
+          member = component_stack.back();
+          component_stack.pop_back();
+          on_stack[member] = 0;
+          component_size++;
+        } while (member != finished);
+        stats.num_strongly_connected_components++;
+        stats.largest_strongly_connected_component =
+            std::max(stats.largest_strongly_connected_component, component_size);
+      }
+    }
+  }
+  return stats;
+}
+
+}  // namespace flatnav::util
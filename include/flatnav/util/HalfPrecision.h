@@ -0,0 +1,168 @@
+#pragma once
+
+#include <flatnav/util/Macros.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace flatnav::util {
+
+/**
+ * @file HalfPrecision.h
+ * @brief 16-bit floating-point storage types.
+ *
+ * `float16_t` is an IEEE 754 half (1 sign, 5 exponent and 10 mantissa bits)
+ * and `bfloat16_t` is the upper half of a float32 (1 sign, 8 exponent and 7
+ * mantissa bits). Both only store vectors: they are converted to float32 when
+ * written (round to nearest even) and when distances are computed.
+ */
+struct float16_t {
+  uint16_t bits;
+};
+
+struct bfloat16_t {
+  uint16_t bits;
+};
+
+inline float toFloat(float value) { return value; }
+
+inline float toFloat(float16_t value) {
+  uint32_t sign = static_cast<uint32_t>(value.bits & 0x8000) << 16;
+  uint32_t exponent = (value.bits >> 10) & 0x1f;
+  uint32_t mantissa = value.bits & 0x3ff;
+  uint32_t bits;
+  if (exponent == 0x1f) {
+    // Infinity or NaN.
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else if (exponent != 0) {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  } else if (mantissa == 0) {
+    bits = sign;
+  } else {
+    // Subnormal halfs are normal floats.
+    exponent = 113;
+    while (!(mantissa & 0x400)) {
+      mantissa <<= 1;
+      exponent--;
+    }
+    bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+  }
+  float result;
+  std::memcpy(&result, &bits, sizeof(float));
+  return result;
+}
+
+inline float toFloat(bfloat16_t value) {
+  uint32_t bits = static_cast<uint32_t>(value.bits) << 16;
+  float result;
+  std::memcpy(&result, &bits, sizeof(float));
+  return result;
+}
+
+inline float16_t toFloat16(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(float));
+  uint16_t sign = (bits >> 16) & 0x8000;
+  uint32_t magnitude = bits & 0x7fffffff;
+
+  if (magnitude >= 0x7f800000) {
+    // Infinity, or a quiet NaN.
+    return {static_cast<uint16_t>(sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0))};
+  }
+  if (magnitude >= 0x477ff000) {
+    // At least 65520, which rounds past the largest half (65504).
+    return {static_cast<uint16_t>(sign | 0x7c00)};
+  }
+
+  uint32_t result, remainder, halfway;
+  if (magnitude < 0x38800000) {
+    // Below 2^-14, i.e. subnormal in half precision.
+    if (magnitude < 0x33000000) {
+      return {sign};
+    }
+    uint32_t shift = 126 - (magnitude >> 23);
+    uint32_t mantissa = (magnitude & 0x7fffff) | 0x800000;
+    result = mantissa >> shift;
+    remainder = mantissa & ((1u << shift) - 1);
+    halfway = 1u << (shift - 1);
+  } else {
+    // Rebias the exponent from 127 to 15 and drop 13 mantissa bits. A
+    // carry out of the mantissa correctly increments the exponent.
+    result = (magnitude - 0x38000000) >> 13;
+    remainder = magnitude & 0x1fff;
+    halfway = 0x1000;
+  }
+  if (remainder > halfway || (remainder == halfway && (result & 1))) {
+    result++;
+  }
+  return {static_cast<uint16_t>(sign | result)};
+}
+
+inline bfloat16_t toBfloat16(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(float));
+  if ((bits & 0x7fffffff) > 0x7f800000) {
+    return {static_cast<uint16_t>((bits >> 16) | 0x40)};
+  }
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return {static_cast<uint16_t>(bits >> 16)};
+}
+
+inline void fromFloat(float value, float16_t& destination) { destination = toFloat16(value); }
+inline void fromFloat(float value, bfloat16_t& destination) { destination = toBfloat16(value); }
+
+/**
+ * @brief Converts `dimension` floats to a 16-bit float type.
+ */
+template <typename T>
+void convertFromFloat(const float* source, T* destination, size_t dimension) {
+  for (size_t i = 0; i < dimension; i++) {
+    fromFloat(source[i], destination[i]);
+  }
+}
+
+/**
+ * @brief Converts `dimension` values of a 16-bit float type to floats.
+ */
+template <typename T>
+void convertToFloat(const T* source, float* destination, size_t dimension) {
+  for (size_t i = 0; i < dimension; i++) {
+    destination[i] = toFloat(source[i]);
+  }
+}
+
+// Loads of 16 (AVX-512) or 8 (AVX2) consecutive values as floats, used by the
+// distance kernels to read float32 queries and 16-bit data alike. float16 is
+// converted with vcvtph2ps and bfloat16 is widened and shifted into the upper
+// half of a float32.
+
+#if defined(BUILD_AVX512_KERNELS)
+// The lanes outside of `mask` are zero and are not read.
+TARGET_AVX512 inline __m512 loadFloats_Avx512(const float* x, __mmask16 mask) {
+  return _mm512_maskz_loadu_ps(mask, x);
+}
+
+TARGET_AVX512 inline __m512 loadFloats_Avx512(const float16_t* x, __mmask16 mask) {
+  return _mm512_cvtph_ps(_mm512_castsi512_si256(_mm512_maskz_loadu_epi16(mask, x)));
+}
+
+TARGET_AVX512 inline __m512 loadFloats_Avx512(const bfloat16_t* x, __mmask16 mask) {
+  __m256i bits = _mm512_castsi512_si256(_mm512_maskz_loadu_epi16(mask, x));
+  return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(bits), 16));
+}
+#endif  // BUILD_AVX512_KERNELS
+
+#if defined(BUILD_AVX2_KERNELS)
+TARGET_AVX2 inline __m256 loadFloats_Avx2(const float* x) { return _mm256_loadu_ps(x); }
+
+TARGET_AVX2 inline __m256 loadFloats_Avx2(const float16_t* x) {
+  return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x)));
+}
+
+TARGET_AVX2 inline __m256 loadFloats_Avx2(const bfloat16_t* x) {
+  __m256i bits = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x)));
+  return _mm256_castsi256_ps(_mm256_slli_epi32(bits, 16));
+}
+#endif  // BUILD_AVX2_KERNELS
+
+}  // namespace flatnav::util
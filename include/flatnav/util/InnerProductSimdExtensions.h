@@ -1,104 +1,273 @@
 #pragma once
 
+#include <flatnav/util/HalfPrecision.h>
 #include <flatnav/util/SimdUtils.h>
 
 namespace flatnav::util {
 
-#if defined(USE_AVX512)
+#if defined(BUILD_AVX512_KERNELS)
+
+// Inner product distance of float vectors of any dimension, 32 floats at a
+// time in two accumulators. The residual dimensions are read with a masked
+// load.
+TARGET_AVX512 static float computeIP_Avx512(const void* x, const void* y, const size_t& dimension) {
+  const float* pointer_x = static_cast<const float*>(x);
+  const float* pointer_y = static_cast<const float*>(y);
+
+  __m512 sum_0 = _mm512_setzero_ps();
+  __m512 sum_1 = _mm512_setzero_ps();
+  size_t i = 0;
+  for (; i + 32 <= dimension; i += 32) {
+    sum_0 = _mm512_fmadd_ps(_mm512_loadu_ps(pointer_x + i), _mm512_loadu_ps(pointer_y + i), sum_0);
+    sum_1 = _mm512_fmadd_ps(_mm512_loadu_ps(pointer_x + i + 16), _mm512_loadu_ps(pointer_y + i + 16), sum_1);
+  }
+  for (; i < dimension; i += 16) {
+    __mmask16 mask = dimension - i >= 16 ? 0xFFFF : (__mmask16)((1u << (dimension - i)) - 1);
+    __m512 v1 = _mm512_maskz_loadu_ps(mask, pointer_x + i);
+    __m512 v2 = _mm512_maskz_loadu_ps(mask, pointer_y + i);
+    sum_0 = _mm512_fmadd_ps(v1, v2, sum_0);
+  }
+  return 1.0f - _mm512_reduce_add_ps(_mm512_add_ps(sum_0, sum_1));
+}
 
-static float computeIP_Avx512(const void* x, const void* y, const size_t& dimension) {
-  float* pointer_x = static_cast<float*>(const_cast<void*>(x));
-  float* pointer_y = static_cast<float*>(const_cast<void*>(y));
+// Inner products of 8-bit vectors are accumulated exactly in 32-bit lanes:
+// every 64 bytes are widened to 16 bits and multiplied with madd, which adds
+// adjacent products into 32 bits. maddubs is not used because it needs one
+// unsigned and one signed operand and saturates its 16-bit pair sums. The
+// tail is read with a masked load, which fills the missing lanes with zeros.
+TARGET_AVX512 static float computeIP_Avx512_int8(const void* x, const void* y, const size_t& dimension) {
+  const int8_t* pointer_x = static_cast<const int8_t*>(x);
+  const int8_t* pointer_y = static_cast<const int8_t*>(y);
+
+  __m512i sum = _mm512_setzero_si512();
+  for (size_t i = 0; i < dimension; i += 64) {
+    __mmask64 mask = dimension - i >= 64 ? ~__mmask64(0) : (__mmask64(1) << (dimension - i)) - 1;
+    __m512i vx = _mm512_maskz_loadu_epi8(mask, pointer_x + i);
+    __m512i vy = _mm512_maskz_loadu_epi8(mask, pointer_y + i);
+
+    __m512i vx_lo = _mm512_cvtepi8_epi16(_mm512_castsi512_si256(vx));
+    __m512i vx_hi = _mm512_cvtepi8_epi16(_mm512_extracti64x4_epi64(vx, 1));
+    __m512i vy_lo = _mm512_cvtepi8_epi16(_mm512_castsi512_si256(vy));
+    __m512i vy_hi = _mm512_cvtepi8_epi16(_mm512_extracti64x4_epi64(vy, 1));
+    sum = _mm512_add_epi32(sum, _mm512_madd_epi16(vx_lo, vy_lo));
+    sum = _mm512_add_epi32(sum, _mm512_madd_epi16(vx_hi, vy_hi));
+  }
+  return 1.0f - static_cast<float>(_mm512_reduce_add_epi32(sum));
+}
 
-  // Align to 16-floats boundary
-  const float* end_x = pointer_x + (dimension >> 4 << 4);
-  simd16float32 product, v1, v2;
+TARGET_AVX512 static float computeIP_Avx512_uint8(const void* x, const void* y, const size_t& dimension) {
+  const uint8_t* pointer_x = static_cast<const uint8_t*>(x);
+  const uint8_t* pointer_y = static_cast<const uint8_t*>(y);
+
+  __m512i sum = _mm512_setzero_si512();
+  for (size_t i = 0; i < dimension; i += 64) {
+    __mmask64 mask = dimension - i >= 64 ? ~__mmask64(0) : (__mmask64(1) << (dimension - i)) - 1;
+    __m512i vx = _mm512_maskz_loadu_epi8(mask, pointer_x + i);
+    __m512i vy = _mm512_maskz_loadu_epi8(mask, pointer_y + i);
+
+    __m512i vx_lo = _mm512_cvtepu8_epi16(_mm512_castsi512_si256(vx));
+    __m512i vx_hi = _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(vx, 1));
+    __m512i vy_lo = _mm512_cvtepu8_epi16(_mm512_castsi512_si256(vy));
+    __m512i vy_hi = _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(vy, 1));
+    sum = _mm512_add_epi32(sum, _mm512_madd_epi16(vx_lo, vy_lo));
+    sum = _mm512_add_epi32(sum, _mm512_madd_epi16(vx_hi, vy_hi));
+  }
+  return 1.0f - static_cast<float>(_mm512_reduce_add_epi32(sum));
+}
 
-  simd16float32 sum(0.0f);
+// Inner product distances on 16-bit float data (float16_t or bfloat16_t), from
+// a float32 query or from a vector of the same type. Values are converted to
+// float32 as they are loaded; the residual dimensions use a masked load.
+template <typename query_t, typename data_t>
+TARGET_AVX512 static float computeIP_Avx512_half(const void* query, const void* data,
+                                                 const size_t& dimension) {
+  const query_t* x = static_cast<const query_t*>(query);
+  const data_t* y = static_cast<const data_t*>(data);
+  __m512 sum_0 = _mm512_setzero_ps();
+  __m512 sum_1 = _mm512_setzero_ps();
+  size_t i = 0;
+  for (; i + 32 <= dimension; i += 32) {
+    sum_0 = _mm512_fmadd_ps(loadFloats_Avx512(x + i, 0xFFFF), loadFloats_Avx512(y + i, 0xFFFF), sum_0);
+    sum_1 =
+        _mm512_fmadd_ps(loadFloats_Avx512(x + i + 16, 0xFFFF), loadFloats_Avx512(y + i + 16, 0xFFFF), sum_1);
+  }
+  for (; i < dimension; i += 16) {
+    __mmask16 mask = dimension - i >= 16 ? 0xFFFF : (__mmask16)((1u << (dimension - i)) - 1);
+    sum_0 = _mm512_fmadd_ps(loadFloats_Avx512(x + i, mask), loadFloats_Avx512(y + i, mask), sum_0);
+  }
+  return 1.0f - _mm512_reduce_add_ps(_mm512_add_ps(sum_0, sum_1));
+}
 
-  while (pointer_x != end_x) {
-    v1.loadu(pointer_x);
-    v2.loadu(pointer_y);
-    product = v1 * v2;
-    sum += product;
-    pointer_x += 16;
-    pointer_y += 16;
+#endif  // BUILD_AVX512_KERNELS
+
+#if defined(BUILD_AVX512VNNI_KERNELS)
+
+// vpdpbusd multiplies unsigned by signed bytes and adds groups of four
+// products into 32-bit lanes, replacing the widening and madd of
+// computeIP_Avx512_int8. One operand is moved to the other signedness by
+// flipping its top bit, which adds or subtracts 128, and the resulting
+// 128 * sum of the other operand is corrected for at the end. That sum comes
+// from vpdpbusd with a vector of ones. Masked tail lanes are zero in both
+// vectors and add nothing.
+TARGET_AVX512VNNI static float computeIP_Avx512Vnni_int8(const void* x, const void* y,
+                                                         const size_t& dimension) {
+  const int8_t* pointer_x = static_cast<const int8_t*>(x);
+  const int8_t* pointer_y = static_cast<const int8_t*>(y);
+  const __m512i sign_bits = _mm512_set1_epi8(static_cast<char>(0x80));
+  const __m512i ones = _mm512_set1_epi8(1);
+
+  // sum = (x + 128) . y, correction = sum(y)
+  __m512i sum = _mm512_setzero_si512();
+  __m512i correction = _mm512_setzero_si512();
+  for (size_t i = 0; i < dimension; i += 64) {
+    __mmask64 mask = dimension - i >= 64 ? ~__mmask64(0) : (__mmask64(1) << (dimension - i)) - 1;
+    __m512i vx = _mm512_maskz_loadu_epi8(mask, pointer_x + i);
+    __m512i vy = _mm512_maskz_loadu_epi8(mask, pointer_y + i);
+
+    sum = _mm512_dpbusd_epi32(sum, _mm512_xor_si512(vx, sign_bits), vy);
+    correction = _mm512_dpbusd_epi32(correction, ones, vy);
   }
-  float total = sum.reduce_add();
-  return 1.0f - total;
+  int32_t inner_product = _mm512_reduce_add_epi32(sum) - 128 * _mm512_reduce_add_epi32(correction);
+  return 1.0f - static_cast<float>(inner_product);
 }
 
-#endif  // USE_AVX512
+TARGET_AVX512VNNI static float computeIP_Avx512Vnni_uint8(const void* x, const void* y,
+                                                          const size_t& dimension) {
+  const uint8_t* pointer_x = static_cast<const uint8_t*>(x);
+  const uint8_t* pointer_y = static_cast<const uint8_t*>(y);
+  const __m512i sign_bits = _mm512_set1_epi8(static_cast<char>(0x80));
+  const __m512i ones = _mm512_set1_epi8(1);
+
+  // sum = x . (y - 128), correction = sum(x)
+  __m512i sum = _mm512_setzero_si512();
+  __m512i correction = _mm512_setzero_si512();
+  for (size_t i = 0; i < dimension; i += 64) {
+    __mmask64 mask = dimension - i >= 64 ? ~__mmask64(0) : (__mmask64(1) << (dimension - i)) - 1;
+    __m512i vx = _mm512_maskz_loadu_epi8(mask, pointer_x + i);
+    __m512i vy = _mm512_maskz_loadu_epi8(mask, pointer_y + i);
+
+    sum = _mm512_dpbusd_epi32(sum, vx, _mm512_xor_si512(vy, sign_bits));
+    correction = _mm512_dpbusd_epi32(correction, vx, ones);
+  }
+  int32_t inner_product = _mm512_reduce_add_epi32(sum) + 128 * _mm512_reduce_add_epi32(correction);
+  return 1.0f - static_cast<float>(inner_product);
+}
 
-#if defined(USE_AVX)
-static float computeIP_Avx(const void* x, const void* y, const size_t& dimension) {
-  float* pointer_x = static_cast<float*>(const_cast<void*>(x));
-  float* pointer_y = static_cast<float*>(const_cast<void*>(y));
+#endif  // BUILD_AVX512VNNI_KERNELS
 
-  const float* end_x = pointer_x + (dimension >> 4 << 4);
-  simd8float32 product, v1, v2;
-  simd8float32 sum(0.0f);
+#if defined(BUILD_AVX2_KERNELS)
 
-  while (pointer_x != end_x) {
-    v1.loadu(pointer_x);
-    v2.loadu(pointer_y);
-    product = v1 * v2;
-    sum += product;
-    pointer_x += 8;
-    pointer_y += 8;
+// Inner product distance of float vectors of any dimension, 16 floats at a
+// time in two accumulators. The residual dimensions are read with a masked
+// load.
+TARGET_AVX2 static float computeIP_Avx(const void* x, const void* y, const size_t& dimension) {
+  const float* pointer_x = static_cast<const float*>(x);
+  const float* pointer_y = static_cast<const float*>(y);
 
-    v1.loadu(pointer_x);
-    v2.loadu(pointer_y);
-    product = v1 * v2;
-    sum += product;
-    pointer_x += 8;
-    pointer_y += 8;
+  __m256 sum_0 = _mm256_setzero_ps();
+  __m256 sum_1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= dimension; i += 16) {
+    sum_0 = _mm256_fmadd_ps(_mm256_loadu_ps(pointer_x + i), _mm256_loadu_ps(pointer_y + i), sum_0);
+    sum_1 = _mm256_fmadd_ps(_mm256_loadu_ps(pointer_x + i + 8), _mm256_loadu_ps(pointer_y + i + 8), sum_1);
   }
-
-  float total = sum.reduce_add();
-  return 1.0f - total;
+  for (; i < dimension; i += 8) {
+    __m256i mask = residualMask_Avx2(dimension - i);
+    __m256 v1 = _mm256_maskload_ps(pointer_x + i, mask);
+    __m256 v2 = _mm256_maskload_ps(pointer_y + i, mask);
+    sum_0 = _mm256_fmadd_ps(v1, v2, sum_0);
+  }
+  return 1.0f - reduceAdd_Avx2(_mm256_add_ps(sum_0, sum_1));
 }
 
-static float computeIP_Avx_4aligned(const void* x, const void* y, const size_t& dimension) {
-
-  float* pointer_x = static_cast<float*>(const_cast<void*>(x));
-  float* pointer_y = static_cast<float*>(const_cast<void*>(y));
-
-  const float* first_chunk_end = pointer_x + (dimension >> 4 << 4);
-  const float* second_chunk_end = pointer_x + (dimension >> 2 << 2);
-
-  simd8float32 v1, v2;
-  simd8float32 sum(0.0f);
+// 8-bit inner products, 32 bytes at a time (see computeIP_Avx512_int8). The
+// residual dimensions are handled with scalar code.
+TARGET_AVX2 static float computeIP_Avx2_int8(const void* x, const void* y, const size_t& dimension) {
+  const int8_t* pointer_x = static_cast<const int8_t*>(x);
+  const int8_t* pointer_y = static_cast<const int8_t*>(y);
+
+  __m256i sum = _mm256_setzero_si256();
+  size_t aligned_dimension = dimension & ~size_t(31);
+  size_t i = 0;
+  for (; i < aligned_dimension; i += 32) {
+    __m256i vx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointer_x + i));
+    __m256i vy = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointer_y + i));
+
+    __m256i vx_lo = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(vx));
+    __m256i vx_hi = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(vx, 1));
+    __m256i vy_lo = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(vy));
+    __m256i vy_hi = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(vy, 1));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(vx_lo, vy_lo));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(vx_hi, vy_hi));
+  }
 
-  while (pointer_x != first_chunk_end) {
-    v1.loadu(pointer_x);
-    v2.loadu(pointer_y);
-    sum += (v1 * v2);
-    pointer_x += 8;
-    pointer_y += 8;
+  int32_t inner_product = 0;
+  for (; i < dimension; i++) {
+    inner_product += pointer_x[i] * pointer_y[i];
   }
+  __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  sum128 = _mm_hadd_epi32(sum128, sum128);
+  sum128 = _mm_hadd_epi32(sum128, sum128);
+  return 1.0f - static_cast<float>(_mm_cvtsi128_si32(sum128) + inner_product);
+}
 
-  // TODO: See if we can reduce this to fewer instructions
-  simd4float32 aggregate = simd4float32(sum.get_low()) + simd4float32(sum.get_high());
-  simd4float32 v1_residual, v2_residual;
+TARGET_AVX2 static float computeIP_Avx2_uint8(const void* x, const void* y, const size_t& dimension) {
+  const uint8_t* pointer_x = static_cast<const uint8_t*>(x);
+  const uint8_t* pointer_y = static_cast<const uint8_t*>(y);
+
+  __m256i sum = _mm256_setzero_si256();
+  size_t aligned_dimension = dimension & ~size_t(31);
+  size_t i = 0;
+  for (; i < aligned_dimension; i += 32) {
+    __m256i vx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointer_x + i));
+    __m256i vy = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointer_y + i));
+
+    __m256i vx_lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(vx));
+    __m256i vx_hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(vx, 1));
+    __m256i vy_lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(vy));
+    __m256i vy_hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(vy, 1));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(vx_lo, vy_lo));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(vx_hi, vy_hi));
+  }
 
-  while (pointer_x != second_chunk_end) {
-    v1_residual.loadu(pointer_x);
-    v2_residual.loadu(pointer_y);
-    aggregate += (v1_residual * v2_residual);
-    pointer_x += 4;
-    pointer_y += 4;
+  int32_t inner_product = 0;
+  for (; i < dimension; i++) {
+    inner_product += pointer_x[i] * pointer_y[i];
   }
+  __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  sum128 = _mm_hadd_epi32(sum128, sum128);
+  sum128 = _mm_hadd_epi32(sum128, sum128);
+  return 1.0f - static_cast<float>(_mm_cvtsi128_si32(sum128) + inner_product);
+}
 
-  float total = aggregate.reduce_add();
-  return 1.0f - total;
+// See computeIP_Avx512_half. The residual dimensions use scalar code.
+template <typename query_t, typename data_t>
+TARGET_AVX2 static float computeIP_Avx2_half(const void* query, const void* data, const size_t& dimension) {
+  const query_t* x = static_cast<const query_t*>(query);
+  const data_t* y = static_cast<const data_t*>(data);
+  __m256 sum_0 = _mm256_setzero_ps();
+  __m256 sum_1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= dimension; i += 16) {
+    sum_0 = _mm256_add_ps(sum_0, _mm256_mul_ps(loadFloats_Avx2(x + i), loadFloats_Avx2(y + i)));
+    sum_1 = _mm256_add_ps(sum_1, _mm256_mul_ps(loadFloats_Avx2(x + i + 8), loadFloats_Avx2(y + i + 8)));
+  }
+  if (i + 8 <= dimension) {
+    sum_0 = _mm256_add_ps(sum_0, _mm256_mul_ps(loadFloats_Avx2(x + i), loadFloats_Avx2(y + i)));
+    i += 8;
+  }
+  float inner_product = reduceAdd_Avx2(_mm256_add_ps(sum_0, sum_1));
+  for (; i < dimension; i++) {
+    inner_product += toFloat(x[i]) * toFloat(y[i]);
+  }
+  return 1.0f - inner_product;
 }
 
-#endif  // USE_AVX
+#endif  // BUILD_AVX2_KERNELS
 
 #if defined(USE_SSE)
 
-const float computeIP_Sse(const void* x, const void* y, const size_t& dimension) {
+static float computeIP_Sse(const void* x, const void* y, const size_t& dimension) {
   float* pointer_x = static_cast<float*>(const_cast<void*>(x));
   float* pointer_y = static_cast<float*>(const_cast<void*>(y));
 
@@ -136,7 +305,7 @@ const float computeIP_Sse(const void* x, const void* y, const size_t& dimension)
   return 1.0f - total;
 }
 
-const float computeIP_Sse_4aligned(const void* x, const void* y, const size_t& dimension) {
+static float computeIP_Sse_4aligned(const void* x, const void* y, const size_t& dimension) {
   float* pointer_x = static_cast<float*>(const_cast<void*>(x));
   float* pointer_y = static_cast<float*>(const_cast<void*>(y));
   const float* first_chunk_end = pointer_x + (dimension >> 4 << 4);
@@ -182,7 +351,7 @@ const float computeIP_Sse_4aligned(const void* x, const void* y, const size_t& d
   return 1.0f - total;
 }
 
-const float computeIP_SseWithResidual_16(const void* x, const void* y, const size_t& dimension) {
+static float computeIP_SseWithResidual_16(const void* x, const void* y, const size_t& dimension) {
   size_t aligned_dimension = dimension >> 4 << 4;
   size_t residual_dimension = dimension - aligned_dimension;
 
@@ -201,7 +370,7 @@ const float computeIP_SseWithResidual_16(const void* x, const void* y, const siz
   return 1.0f - (first_chunk_sum + residual_sum);
 }
 
-const float computeIP_SseWithResidual_4(const void* x, const void* y, const size_t& dimension) {
+static float computeIP_SseWithResidual_4(const void* x, const void* y, const size_t& dimension) {
   size_t aligned_dimension = dimension >> 2 << 2;
   size_t residual_dimension = dimension - aligned_dimension;
 
@@ -220,6 +389,62 @@ const float computeIP_SseWithResidual_4(const void* x, const void* y, const size
   return 1.0f - (first_chunk_sum + residual_sum);
 }
 
+#if defined(USE_SSE4_1)
+
+// 8-bit inner products, 16 bytes at a time (see computeIP_Avx512_int8). The
+// residual dimensions are handled with scalar code.
+static float computeIP_Sse_int8(const void* x, const void* y, const size_t& dimension) {
+  const int8_t* pointer_x = static_cast<const int8_t*>(x);
+  const int8_t* pointer_y = static_cast<const int8_t*>(y);
+
+  __m128i sum = _mm_setzero_si128();
+  size_t aligned_dimension = dimension & ~size_t(15);
+  size_t i = 0;
+  for (; i < aligned_dimension; i += 16) {
+    __m128i vx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointer_x + i));
+    __m128i vy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointer_y + i));
+
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_cvtepi8_epi16(vx), _mm_cvtepi8_epi16(vy)));
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_cvtepi8_epi16(_mm_srli_si128(vx, 8)),
+                                            _mm_cvtepi8_epi16(_mm_srli_si128(vy, 8))));
+  }
+
+  int32_t inner_product = 0;
+  for (; i < dimension; i++) {
+    inner_product += pointer_x[i] * pointer_y[i];
+  }
+  sum = _mm_hadd_epi32(sum, sum);
+  sum = _mm_hadd_epi32(sum, sum);
+  return 1.0f - static_cast<float>(_mm_cvtsi128_si32(sum) + inner_product);
+}
+
+static float computeIP_Sse_uint8(const void* x, const void* y, const size_t& dimension) {
+  const uint8_t* pointer_x = static_cast<const uint8_t*>(x);
+  const uint8_t* pointer_y = static_cast<const uint8_t*>(y);
+
+  __m128i sum = _mm_setzero_si128();
+  size_t aligned_dimension = dimension & ~size_t(15);
+  size_t i = 0;
+  for (; i < aligned_dimension; i += 16) {
+    __m128i vx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointer_x + i));
+    __m128i vy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointer_y + i));
+
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_cvtepu8_epi16(vx), _mm_cvtepu8_epi16(vy)));
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(vx, 8)),
+                                            _mm_cvtepu8_epi16(_mm_srli_si128(vy, 8))));
+  }
+
+  int32_t inner_product = 0;
+  for (; i < dimension; i++) {
+    inner_product += pointer_x[i] * pointer_y[i];
+  }
+  sum = _mm_hadd_epi32(sum, sum);
+  sum = _mm_hadd_epi32(sum, sum);
+  return 1.0f - static_cast<float>(_mm_cvtsi128_si32(sum) + inner_product);
+}
+
+#endif  // USE_SSE4_1
+
 #endif  // USE_SSE
 
 }  // namespace flatnav::util
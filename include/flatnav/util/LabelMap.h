@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace flatnav::util {
+
+/**
+ * @brief Open-addressing hash table mapping labels to internal node ids.
+ *
+ * Labels already live inside each node of the index, so the table only
+ * stores node ids. A probe compares the requested label with the label of the
+ * node found in the slot, which is read through the `get_label` callable
+ * supplied by the caller. This keeps the table at sizeof(node_id_t) bytes per
+ * slot. The capacity is fixed at construction to a power of two at least twice
+ * the maximum number of labels, so the load factor never exceeds 0.5 and
+ * linear probing stays short.
+ *
+ * Inserting a label that is already present re-points it to the new node.
+ * The table is not thread-safe; callers must serialize inserts.
+ *
+ * @tparam label_t The label (meta-data) type of the index.
+ * @tparam node_id_t The internal node id type of the index.
+ */
+template <typename label_t, typename node_id_t>
+class LabelMap {
+  static constexpr node_id_t EMPTY_SLOT = std::numeric_limits<node_id_t>::max();
+
+  std::vector<node_id_t> _slots;
+  uint64_t _mask;
+
+  inline uint64_t slotFor(const label_t& label) const {
+    // Fibonacci hashing spreads out labels that std::hash maps to consecutive
+    // values (e.g. integers), which would otherwise form long probe runs.
+    uint64_t hash = static_cast<uint64_t>(std::hash<label_t>{}(label));
+    return (hash * 0x9E3779B97F4A7C15ULL) & _mask;
+  }
+
+ public:
+  LabelMap(uint64_t max_num_labels) {
+    uint64_t capacity = 1;
+    while (capacity < 2 * max_num_labels) {
+      capacity <<= 1;
+    }
+    _slots.assign(capacity, EMPTY_SLOT);
+    _mask = capacity - 1;
+  }
+
+  template <typename GetLabel>
+  void insert(const label_t& label, node_id_t node_id, GetLabel&& get_label) {
+    uint64_t slot = slotFor(label);
+    while (_slots[slot] != EMPTY_SLOT && !(get_label(_slots[slot]) == label)) {
+      slot = (slot + 1) & _mask;
+    }
+    _slots[slot] = node_id;
+  }
+
+  template <typename GetLabel>
+  std::optional<node_id_t> find(const label_t& label, GetLabel&& get_label) const {
+    uint64_t slot = slotFor(label);
+    while (_slots[slot] != EMPTY_SLOT) {
+      if (get_label(_slots[slot]) == label) {
+        return _slots[slot];
+      }
+      slot = (slot + 1) & _mask;
+    }
+    return std::nullopt;
+  }
+
+  inline uint64_t allocatedMemory() const { return _slots.size() * sizeof(node_id_t); }
+};
+
+}  // namespace flatnav::util
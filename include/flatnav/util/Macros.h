@@ -20,6 +20,14 @@
 #ifdef __AVX__
 #define USE_AVX
 
+#ifdef __AVX2__
+#define USE_AVX2
+#endif  // __AVX2__
+
+#ifdef __F16C__
+#define USE_F16C
+#endif  // __F16C__
+
 #ifdef __AVX512F__
 
 #ifdef __AVX512BW__
@@ -37,6 +45,35 @@
 #endif
 #endif  // NO_SIMD_VECTORIZATION
 
+// The AVX2 and AVX-512 distance kernels are compiled for their instruction set
+// with target attributes, whatever the flags of the build, so that a build
+// for an older baseline (e.g. a portable wheel) still contains them. Each
+// distance picks its kernel once, when it is constructed, among those that
+// the CPU supports. Compilers without target attributes only get the kernels
+// of the instruction sets enabled for the whole build.
+#if defined(USE_SSE) && defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx512dq,avx2,fma,f16c")))
+#define TARGET_AVX512VNNI \
+  __attribute__((target("avx512f,avx512bw,avx512vl,avx512dq,avx512vnni,avx2,fma,f16c")))
+#define BUILD_AVX2_KERNELS
+#define BUILD_AVX512_KERNELS
+#define BUILD_AVX512VNNI_KERNELS
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#define TARGET_AVX512VNNI
+#if defined(USE_AVX2) && defined(USE_F16C) && defined(__FMA__)
+#define BUILD_AVX2_KERNELS
+#endif
+#if defined(USE_AVX512BW) && defined(__AVX512VL__) && defined(__AVX512DQ__) && defined(BUILD_AVX2_KERNELS)
+#define BUILD_AVX512_KERNELS
+#endif
+#if defined(USE_AVX512VNNI) && defined(BUILD_AVX512_KERNELS)
+#define BUILD_AVX512VNNI_KERNELS
+#endif
+#endif
+
 #if defined(USE_AVX) || defined(USE_SSE)
 
 // This would not work on WindowsOS
@@ -44,7 +81,7 @@
 #include <stdint.h>
 #include <x86intrin.h>
 
-void cpuid(int32_t cpu_info[4], int32_t eax, int32_t ecx) {
+inline void cpuid(int32_t cpu_info[4], int32_t eax, int32_t ecx) {
   __cpuid_count(eax, ecx, cpu_info[0], cpu_info[1], cpu_info[2], cpu_info[3]);
 }
 
@@ -71,7 +108,7 @@ void cpuid(int32_t cpu_info[4], int32_t eax, int32_t ecx) {
  * The result is constructed by shifting 'edx' left by 32 bits and combining it
  * with 'eax' using bitwise OR.
  */
-uint64_t xgetbv(unsigned int index) {
+inline uint64_t xgetbv(unsigned int index) {
   uint32_t eax, edx;
   __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
   return ((uint64_t)edx << 32) | eax;
@@ -94,10 +131,16 @@ uint64_t xgetbv(unsigned int index) {
 #define _XCR_XFEATURE_ENABLED_MASK 0
 
 // Cache for AVX and AVX512 support
-std::atomic<bool> avx_support_cache{false};
-std::atomic<bool> avx_512_support_cache{false};
-std::atomic<bool> avx_initialized{false};
-std::atomic<bool> avx_512_initialized{false};
+inline std::atomic<bool> avx_support_cache{false};
+inline std::atomic<bool> avx_512_support_cache{false};
+inline std::atomic<bool> avx_initialized{false};
+inline std::atomic<bool> avx_512_initialized{false};
+inline std::atomic<bool> avx_512_vnni_support_cache{false};
+inline std::atomic<bool> avx_512_vnni_initialized{false};
+inline std::atomic<bool> avx2_support_cache{false};
+inline std::atomic<bool> avx2_initialized{false};
+inline std::atomic<bool> avx_512_bw_support_cache{false};
+inline std::atomic<bool> avx_512_bw_initialized{false};
 
 /**
  * @brief Initializes the platform support for AVX and AVX512 instructions.
@@ -107,7 +150,7 @@ std::atomic<bool> avx_512_initialized{false};
  * @note This function should be called before using any AVX or AVX512
  * instructions.
  */
-void initializePlatformSupport() {
+inline void initializePlatformSupport() {
   if (!avx_initialized.load(std::memory_order_acquire)) {
     bool avx_support = false;
     int cpu_info[4];
@@ -157,18 +200,89 @@ void initializePlatformSupport() {
   }
 }
 
-bool platformSupportsAvx() {
+inline bool platformSupportsAvx() {
   if (!avx_initialized.load(std::memory_order_acquire)) {
     initializePlatformSupport();
   }
   return avx_support_cache.load(std::memory_order_acquire);
 }
 
-bool platformSupportsAvx512() {
+inline bool platformSupportsAvx512() {
   if (!avx_512_initialized.load(std::memory_order_acquire)) {
     initializePlatformSupport();
   }
   return avx_512_support_cache.load(std::memory_order_acquire);
 }
 
+/**
+ * @brief Checks if the CPU supports AVX2 with FMA and F16C, which the AVX2
+ * distance kernels use, i.e. Haswell and later Intel CPUs and all AMD Zen
+ * CPUs. The result is cached.
+ */
+inline bool platformSupportsAvx2() {
+  if (!avx2_initialized.load(std::memory_order_acquire)) {
+    bool avx2_support = false;
+    if (platformSupportsAvx()) {
+      int cpu_info[4];
+      cpuid(cpu_info, 1, 0);
+      bool hw_fma = (cpu_info[2] & (1 << 12)) != 0;
+      bool hw_f16c = (cpu_info[2] & (1 << 29)) != 0;
+      cpuid(cpu_info, 0, 0);
+      if (cpu_info[0] >= 0x00000007) {
+        cpuid(cpu_info, 0x00000007, 0);
+        bool hw_avx2 = (cpu_info[1] & (1 << 5)) != 0;
+        avx2_support = hw_avx2 && hw_fma && hw_f16c;
+      }
+    }
+
+    avx2_support_cache.store(avx2_support, std::memory_order_release);
+    avx2_initialized.store(true, std::memory_order_release);
+  }
+  return avx2_support_cache.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Checks if the CPU supports the AVX512F, BW, VL and DQ subsets that
+ * the AVX-512 distance kernels use, i.e. Skylake-SP and later Intel CPUs and
+ * AMD Zen 4 and later. The result is cached.
+ */
+inline bool platformSupportsAvx512Bw() {
+  if (!avx_512_bw_initialized.load(std::memory_order_acquire)) {
+    bool bw_support = false;
+    if (platformSupportsAvx512() && platformSupportsAvx2()) {
+      int cpu_info[4];
+      cpuid(cpu_info, 0x00000007, 0);
+      bool hw_avx512dq = (cpu_info[1] & ((int)1 << 17)) != 0;
+      bool hw_avx512bw = (cpu_info[1] & ((int)1 << 30)) != 0;
+      bool hw_avx512vl = (cpu_info[1] & ((int)1 << 31)) != 0;
+      bw_support = hw_avx512dq && hw_avx512bw && hw_avx512vl;
+    }
+
+    avx_512_bw_support_cache.store(bw_support, std::memory_order_release);
+    avx_512_bw_initialized.store(true, std::memory_order_release);
+  }
+  return avx_512_bw_support_cache.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Checks if the CPU supports the AVX512 VNNI (vpdpbusd, vpdpwssd)
+ * instructions used by the 8-bit distance kernels, on top of those of
+ * platformSupportsAvx512Bw, i.e. Cascade Lake, Ice Lake and later Intel CPUs
+ * and AMD Zen 4 and later. The result is cached.
+ */
+inline bool platformSupportsAvx512Vnni() {
+  if (!avx_512_vnni_initialized.load(std::memory_order_acquire)) {
+    bool vnni_support = false;
+    if (platformSupportsAvx512Bw()) {
+      int cpu_info[4];
+      cpuid(cpu_info, 0x00000007, 0);
+      vnni_support = (cpu_info[2] & ((int)1 << 11)) != 0;
+    }
+
+    avx_512_vnni_support_cache.store(vnni_support, std::memory_order_release);
+    avx_512_vnni_initialized.store(true, std::memory_order_release);
+  }
+  return avx_512_vnni_support_cache.load(std::memory_order_acquire);
+}
+
 #endif
\ No newline at end of file
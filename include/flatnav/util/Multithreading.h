@@ -16,7 +16,7 @@ namespace flatnav {
  * installing the Python library.
  */
 template <typename Function, typename... Args>
-void executeInParallel(uint32_t start_index, uint32_t end_index, uint32_t num_threads, Function function,
+void executeInParallel(uint64_t start_index, uint64_t end_index, uint32_t num_threads, Function function,
                        Args... additional_args) {
   if (num_threads == 0) {
     throw std::invalid_argument("Invalid number of threads");
@@ -24,12 +24,12 @@ void executeInParallel(uint32_t start_index, uint32_t end_index, uint32_t num_th
 
   // This needs to be an atomic because mutliple threads will be
   // modifying it concurrently.
-  std::atomic<uint32_t> current(start_index);
+  std::atomic<uint64_t> current(start_index);
   std::thread thread_objects[num_threads];
 
   auto parallel_executor = [&] {
     while (true) {
-      uint32_t current_vector_idx = current.fetch_add(1);
+      uint64_t current_vector_idx = current.fetch_add(1);
       if (current_vector_idx >= end_index) {
         break;
       }
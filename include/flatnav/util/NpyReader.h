@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace flatnav::util {
+
+/**
+ * @brief A 2D array read from a .npy file. The elements are kept in their
+ * on-disk representation, described by `descr` (e.g. "<i4").
+ */
+struct NpyMatrix {
+  std::string descr;
+  uint64_t rows;
+  uint64_t cols;
+  std::vector<char> data;
+
+  template <typename T>
+  const T* as() const {
+    return reinterpret_cast<const T*>(data.data());
+  }
+};
+
+/**
+ * @brief Reads a C-ordered 2D array from a .npy file (format versions 1 to 3).
+ * Only the header fields needed to locate the data are parsed.
+ *
+ * @exception std::runtime_error Thrown if the file cannot be read, is not a
+ * .npy file, or does not hold a C-ordered 2D array.
+ */
+inline NpyMatrix loadNpyMatrix(const std::string& filename) {
+  std::ifstream stream(filename, std::ios::binary);
+  if (!stream.is_open()) {
+    throw std::runtime_error("Unable to open file for reading: " + filename);
+  }
+
+  char magic[6];
+  uint8_t version[2];
+  stream.read(magic, sizeof(magic));
+  stream.read(reinterpret_cast<char*>(version), sizeof(version));
+  if (!stream || std::string(magic, sizeof(magic)) != "\x93NUMPY") {
+    throw std::runtime_error(filename + " is not a .npy file.");
+  }
+
+  uint32_t header_length = 0;
+  if (version[0] == 1) {
+    uint8_t length_bytes[2];
+    stream.read(reinterpret_cast<char*>(length_bytes), sizeof(length_bytes));
+    header_length = length_bytes[0] | (length_bytes[1] << 8);
+  } else {
+    uint8_t length_bytes[4];
+    stream.read(reinterpret_cast<char*>(length_bytes), sizeof(length_bytes));
+    header_length = length_bytes[0] | (length_bytes[1] << 8) | (length_bytes[2] << 16) |
+                    (static_cast<uint32_t>(length_bytes[3]) << 24);
+  }
+  std::string header(header_length, '\0');
+  stream.read(header.data(), header_length);
+  if (!stream) {
+    throw std::runtime_error("Truncated .npy header in " + filename);
+  }
+
+  // The header is a Python dict literal, e.g.
+  // {'descr': '<i4', 'fortran_order': False, 'shape': (1000, 32), }
+  auto valueOf = [&](const std::string& key) {
+    size_t position = header.find("'" + key + "'");
+    if (position == std::string::npos) {
+      throw std::runtime_error("Missing `" + key + "` in .npy header of " + filename);
+    }
+    return header.find(':', position) + 1;
+  };
+
+  NpyMatrix matrix;
+  size_t descr_start = header.find('\'', valueOf("descr")) + 1;
+  matrix.descr = header.substr(descr_start, header.find('\'', descr_start) - descr_start);
+
+  if (header.compare(header.find_first_not_of(' ', valueOf("fortran_order")), 5, "False") != 0) {
+    throw std::runtime_error("Fortran-ordered arrays are not supported: " + filename);
+  }
+
+  size_t shape_start = header.find('(', valueOf("shape")) + 1;
+  std::string shape = header.substr(shape_start, header.find(')', shape_start) - shape_start);
+  size_t comma = shape.find(',');
+  if (comma == std::string::npos || shape.find_first_of("0123456789", comma) == std::string::npos) {
+    throw std::runtime_error("Expected a 2D array in " + filename + ", got shape (" + shape + ").");
+  }
+  matrix.rows = std::stoull(shape.substr(0, comma));
+  matrix.cols = std::stoull(shape.substr(comma + 1));
+
+  size_t element_size = std::stoul(matrix.descr.substr(2));
+  matrix.data.resize(matrix.rows * matrix.cols * element_size);
+  stream.read(matrix.data.data(), matrix.data.size());
+  if (!stream) {
+    throw std::runtime_error("Truncated .npy data in " + filename);
+  }
+  return matrix;
+}
+
+}  // namespace flatnav::util
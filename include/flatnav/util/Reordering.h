@@ -1,30 +1,52 @@
 #pragma once
 
+#include <flatnav/util/CsrGraph.h>
 #include <flatnav/util/GorderPriorityQueue.h>
+#include <flatnav/util/Multithreading.h>
 #include <flatnav/util/VisitedSetPool.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
 #include <queue>
+#include <random>
 #include <utility>
 #include <vector>
 
-// All algorithms make the following assumptions:
-// input is a vector of vectors called outdegree_table, where
-// outdegree_table[node] is a vector of the outbound edges from node
-// template parameter is the type of nodes in the table. This should
-// be an integral type. Nodes in the graph should be labeled from
-// 0 to N-1 (where N is the number of nodes in the graph) with no
-// non-existent nodes.
+// All graph algorithms make the following assumptions:
+// input is a CsrGraph called graph, where graph.neighbors(node) are
+// the outbound edges from node. The template parameter is the type of
+// nodes in the graph. This should be an integral type. Nodes in the
+// graph should be labeled from 0 to N-1 (where N is the number of
+// nodes in the graph) with no non-existent nodes.
 //
-// All functions must accept outdegree_table and return a permutation
+// All functions must return a permutation
 // P. P is a length-N vector where P[i] is the new node ID of the
 // node currently labeled "i". That is, to find the new label of
 // node "i", we look at P[i].
 
 namespace flatnav::util {
 
+/**
+ * Runs `function` on every index in [start_index, end_index), on the calling
+ * thread if `num_threads` is 1.
+ */
+template <typename Function>
+void parallelRange(uint64_t start_index, uint64_t end_index, uint32_t num_threads, Function function) {
+  if (num_threads <= 1) {
+    for (uint64_t index = start_index; index < end_index; index++) {
+      function(index);
+    }
+    return;
+  }
+  flatnav::executeInParallel(start_index, end_index, num_threads, function);
+}
+
 template <typename node_id_t>
-std::vector<node_id_t> gOrder(std::vector<std::vector<node_id_t>>& outdegree_table, const int w) {
+std::vector<node_id_t> gOrder(const CsrGraph<node_id_t>& graph, const int w) {
   /* Simple explanation of the Gorder Algorithm:
   insert all v into Q each with priority 0
   select a start node into P
@@ -50,14 +72,9 @@ std::vector<node_id_t> gOrder(std::vector<std::vector<node_id_t>>& outdegree_tab
       i++
   */
 
-  int cur_num_nodes = outdegree_table.size();
+  size_t cur_num_nodes = graph.numNodes();
   // create table of in-degrees
-  std::vector<std::vector<node_id_t>> indegree_table(cur_num_nodes);
-  for (node_id_t node = 0; node < cur_num_nodes; node++) {
-    for (node_id_t& edge : outdegree_table[node]) {
-      indegree_table[edge].push_back(node);
-    }
-  }
+  CsrGraph<node_id_t> reversed_graph = graph.transpose();
 
   GorderPriorityQueue<node_id_t> Q(cur_num_nodes);
   std::vector<node_id_t> P(cur_num_nodes, 0);
@@ -67,19 +84,19 @@ std::vector<node_id_t> gOrder(std::vector<std::vector<node_id_t>>& outdegree_tab
   P[0] = Q.pop();
 
   // for i = 1 to N:
-  for (int i = 1; i < cur_num_nodes; i++) {
+  for (size_t i = 1; i < cur_num_nodes; i++) {
     node_id_t v_e = P[i - 1];
     // ve = newest node in window
     // for each node u in out-edges of ve:
-    for (node_id_t& u : outdegree_table[v_e]) {
+    for (node_id_t u : graph.neighbors(v_e)) {
       Q.increment(u);
     }
     // for each node u in in-edges of v_e:
-    for (node_id_t& u : indegree_table[v_e]) {
+    for (node_id_t u : reversed_graph.neighbors(v_e)) {
       // if u in Q, increment priority of u
       Q.increment(u);
       // for each node v in out-edges of u:
-      for (node_id_t& v : outdegree_table[u]) {
+      for (node_id_t v : graph.neighbors(u)) {
         Q.increment(v);
       }
     }
@@ -87,12 +104,12 @@ std::vector<node_id_t> gOrder(std::vector<std::vector<node_id_t>>& outdegree_tab
     if (i > w + 1) {
       node_id_t v_b = P[i - w - 1];
       // for each node u in out-edges of vb:
-      for (node_id_t& u : outdegree_table[v_b]) {
+      for (node_id_t u : graph.neighbors(v_b)) {
         Q.decrement(u);
       }
 
       // for each node u in in-edges of v_b
-      for (node_id_t& u : indegree_table[v_b]) {
+      for (node_id_t u : reversed_graph.neighbors(v_b)) {
         // if u in Q, increment priority of u
         // Note: it doesn't seem to matter whether this particular
         // operation is an increment or a decrement. In a previous
@@ -100,7 +117,7 @@ std::vector<node_id_t> gOrder(std::vector<std::vector<node_id_t>>& outdegree_tab
         // technically wrong) but the performance was nearly the same.
         Q.decrement(u);
         // for each node v in out-edges of u:
-        for (node_id_t& v : outdegree_table[u]) {
+        for (node_id_t v : graph.neighbors(u)) {
           Q.decrement(v);
         }
       }
@@ -109,91 +126,463 @@ std::vector<node_id_t> gOrder(std::vector<std::vector<node_id_t>>& outdegree_tab
   }
 
   std::vector<node_id_t> Pinv(cur_num_nodes, 0);
-  for (int n = 0; n < cur_num_nodes; n++) {
+  for (size_t n = 0; n < cur_num_nodes; n++) {
     Pinv[P[n]] = n;
   }
   // now we have a mapping Pinv[i] -> new label of node i
   return Pinv;
 }
 
+/**
+ * Parallel, partitioned variant of gOrder. The nodes are split into
+ * `num_partitions` contiguous ranges of a BFS order, so that every partition
+ * is a connected, local region of the graph. Gorder then runs concurrently on
+ * the subgraph induced by each partition, and the partitions are laid out one
+ * after the other in BFS order. Edges between partitions are ignored while
+ * ordering, which loses little locality as long as partitions are much larger
+ * than the window.
+ */
 template <typename node_id_t>
-std::vector<node_id_t> rcmOrder(std::vector<std::vector<node_id_t>>& outdegree_table) {
+std::vector<node_id_t> parallelGOrder(const CsrGraph<node_id_t>& graph, const int w,
+                                      size_t num_partitions, uint32_t num_threads) {
+  size_t cur_num_nodes = graph.numNodes();
+  num_partitions = std::max<size_t>(std::min(num_partitions, cur_num_nodes), 1);
 
-  int cur_num_nodes = outdegree_table.size();
-  std::vector<std::pair<node_id_t, int>> sorted_nodes;
-  std::vector<int> degrees;
+  // BFS order over the out-edges, restarted from the first unvisited node
+  // until every node is reached.
+  std::vector<node_id_t> bfs_order;
+  bfs_order.reserve(cur_num_nodes);
+  std::vector<bool> visited(cur_num_nodes, false);
+  for (size_t start = 0; start < cur_num_nodes; start++) {
+    if (visited[start]) {
+      continue;
+    }
+    size_t head = bfs_order.size();
+    bfs_order.push_back(start);
+    visited[start] = true;
+    while (head < bfs_order.size()) {
+      node_id_t node = bfs_order[head++];
+      for (node_id_t neighbor : graph.neighbors(node)) {
+        if (!visited[neighbor]) {
+          visited[neighbor] = true;
+          bfs_order.push_back(neighbor);
+        }
+      }
+    }
+  }
 
-  for (node_id_t node = 0; node < cur_num_nodes; node++) {
-    int deg = outdegree_table[node].size();
-    sorted_nodes.push_back({node, deg});
-    degrees.push_back(deg);
+  size_t partition_size = (cur_num_nodes + num_partitions - 1) / num_partitions;
+  std::vector<size_t> bfs_position(cur_num_nodes);
+  for (size_t position = 0; position < cur_num_nodes; position++) {
+    bfs_position[bfs_order[position]] = position;
   }
 
-  std::sort(sorted_nodes.begin(), sorted_nodes.end(),
-            [](const std::pair<node_id_t, int>& a, const std::pair<node_id_t, int>& b) {
-              return a.second < b.second;
-            });
+  std::vector<node_id_t> Pinv(cur_num_nodes, 0);
+  auto order_partition = [&](uint64_t partition) {
+    size_t begin = partition * partition_size;
+    size_t end = std::min(begin + partition_size, cur_num_nodes);
+    if (begin >= end) {
+      return;
+    }
+    // Subgraph induced by the partition, with nodes numbered by BFS position.
+    CsrGraph<node_id_t> local_graph;
+    local_graph.offsets.reserve(end - begin + 1);
+    for (size_t position = begin; position < end; position++) {
+      for (node_id_t neighbor : graph.neighbors(bfs_order[position])) {
+        if (bfs_position[neighbor] >= begin && bfs_position[neighbor] < end) {
+          local_graph.targets.push_back(bfs_position[neighbor] - begin);
+        }
+      }
+      local_graph.offsets.push_back(local_graph.targets.size());
+    }
+    std::vector<node_id_t> local_Pinv = gOrder<node_id_t>(local_graph, w);
+    for (size_t position = begin; position < end; position++) {
+      Pinv[bfs_order[position]] = begin + local_Pinv[position - begin];
+    }
+  };
 
-  std::vector<node_id_t> P;
-  auto visited_set = VisitedSet(cur_num_nodes);
-  visited_set.clear();
+  parallelRange(/* start_index = */ 0, /* end_index = */ num_partitions, num_threads, order_partition);
+  return Pinv;
+}
+
+/**
+ * Workload-driven ordering. Nodes that queries visited (non-zero frequency)
+ * come first: hubs are taken in decreasing frequency, and each is followed by
+ * its not yet placed visited neighbors up to `depth` hops away, closest and
+ * most frequent first. The nodes a search expands from a hub then share pages
+ * and cache lines with it. Unvisited nodes follow in their current order, so
+ * that the layout of a previous reordering is kept for cold nodes.
+ */
+template <typename node_id_t>
+std::vector<node_id_t> hubOrder(const CsrGraph<node_id_t>& graph,
+                                const std::vector<uint32_t>& frequencies, const int depth = 1) {
+  size_t cur_num_nodes = graph.numNodes();
+  auto by_frequency = [&](node_id_t a, node_id_t b) {
+    return frequencies[a] != frequencies[b] ? frequencies[a] > frequencies[b] : a < b;
+  };
 
-  for (int i = 0; i < sorted_nodes.size(); i++) {
-    node_id_t node = sorted_nodes[i].first;
-    std::queue<node_id_t> Q;
+  std::vector<node_id_t> hubs;
+  for (node_id_t node = 0; node < cur_num_nodes; node++) {
+    if (frequencies[node] > 0) {
+      hubs.push_back(node);
+    }
+  }
+  std::sort(hubs.begin(), hubs.end(), by_frequency);
 
-    if (!visited_set.isVisited(node)) {
-      // add node to permutation
+  std::vector<node_id_t> P;
+  P.reserve(cur_num_nodes);
+  std::vector<bool> placed(cur_num_nodes, false);
+  for (node_id_t hub : hubs) {
+    if (placed[hub]) {
+      continue;
+    }
+    // BFS over visited nodes, one level at a time.
+    std::vector<node_id_t> level = {hub};
+    placed[hub] = true;
+    P.push_back(hub);
+    for (int hop = 0; hop < depth && !level.empty(); hop++) {
+      std::vector<node_id_t> next_level;
+      for (node_id_t node : level) {
+        for (node_id_t neighbor : graph.neighbors(node)) {
+          if (!placed[neighbor] && frequencies[neighbor] > 0) {
+            placed[neighbor] = true;
+            next_level.push_back(neighbor);
+          }
+        }
+      }
+      std::sort(next_level.begin(), next_level.end(), by_frequency);
+      P.insert(P.end(), next_level.begin(), next_level.end());
+      level = std::move(next_level);
+    }
+  }
+  for (node_id_t node = 0; node < cur_num_nodes; node++) {
+    if (!placed[node]) {
       P.push_back(node);
-      visited_set.insert(node);
+    }
+  }
+
+  std::vector<node_id_t> Pinv(cur_num_nodes, 0);
+  for (size_t n = 0; n < cur_num_nodes; n++) {
+    Pinv[P[n]] = n;
+  }
+  return Pinv;
+}
 
-      // get list of neighbors
-      std::vector<std::pair<node_id_t, int>> neighbors;
-      for (auto& edge : outdegree_table[node]) {
-        neighbors.push_back({edge, degrees[edge]});
+/**
+ * Vector-space ordering: nodes sorted by the Z-order (Morton) key of their
+ * vector projected onto `num_projections` random Gaussian directions. Each
+ * projection is quantized to 64 / num_projections bits (at most 63) over its
+ * range, and the bits are interleaved, so that nearby vectors tend to get
+ * nearby keys.
+ * Unlike the graph orderings, this does not need the outdegree table: node
+ * vectors are read through `read_vector(node, float* destination)`.
+ */
+template <typename node_id_t, typename VectorReader>
+std::vector<node_id_t> zOrder(size_t num_nodes, size_t dim, VectorReader read_vector, uint32_t num_threads,
+                              int num_projections = 8, uint64_t seed = 1234) {
+  num_projections = std::clamp(num_projections, 1, 64);
+  std::mt19937_64 generator(seed);
+  std::normal_distribution<float> distribution(0.0f, 1.0f);
+  std::vector<float> directions(num_projections * dim);
+  for (auto& value : directions) {
+    value = distribution(generator);
+  }
+
+  std::vector<float> projections(num_nodes * num_projections);
+  auto project = [&](uint64_t node, std::vector<float>& vector) {
+    read_vector(static_cast<node_id_t>(node), vector.data());
+    for (int p = 0; p < num_projections; p++) {
+      float projection = 0;
+      for (size_t d = 0; d < dim; d++) {
+        projection += directions[p * dim + d] * vector[d];
       }
+      projections[node * num_projections + p] = projection;
+    }
+  };
+  // Nodes are processed in blocks to reuse the vector buffer.
+  static constexpr size_t NODES_PER_BLOCK = 1024;
+  auto project_block = [&](uint64_t block) {
+    std::vector<float> vector(dim);
+    for (size_t node = block * NODES_PER_BLOCK; node < std::min((block + 1) * NODES_PER_BLOCK, num_nodes);
+         node++) {
+      project(node, vector);
+    }
+  };
+  size_t num_blocks = (num_nodes + NODES_PER_BLOCK - 1) / NODES_PER_BLOCK;
+  parallelRange(/* start_index = */ 0, /* end_index = */ num_blocks, num_threads, project_block);
 
-      // sort neighbors by degree (min degree first)
-      std::sort(neighbors.begin(), neighbors.end(),
-                [](const std::pair<node_id_t, int>& a, const std::pair<node_id_t, int>& b) {
-                  return a.second < b.second;
-                });
+  std::vector<float> lower(num_projections, std::numeric_limits<float>::max());
+  std::vector<float> upper(num_projections, std::numeric_limits<float>::lowest());
+  for (size_t node = 0; node < num_nodes; node++) {
+    for (int p = 0; p < num_projections; p++) {
+      lower[p] = std::min(lower[p], projections[node * num_projections + p]);
+      upper[p] = std::max(upper[p], projections[node * num_projections + p]);
+    }
+  }
 
-      // add neighbors to queue
-      for (int j = 0; j < neighbors.size(); j++) {
-        Q.push(neighbors[j].first);
+  // At most 63 bits, so that scaled * max_cell, which rounds up to 2^bits in
+  // float, still converts to uint64_t.
+  int bits = std::min(64 / num_projections, 63);
+  uint64_t max_cell = (uint64_t(1) << bits) - 1;
+  std::vector<std::pair<uint64_t, node_id_t>> keys(num_nodes);
+  std::vector<uint64_t> cells(num_projections);
+  for (size_t node = 0; node < num_nodes; node++) {
+    for (int p = 0; p < num_projections; p++) {
+      float range = upper[p] - lower[p];
+      float scaled = range > 0 ? (projections[node * num_projections + p] - lower[p]) / range : 0;
+      cells[p] = std::min(static_cast<uint64_t>(scaled * max_cell), max_cell);
+    }
+    uint64_t key = 0;
+    for (int bit = bits - 1; bit >= 0; bit--) {
+      for (int p = 0; p < num_projections; p++) {
+        key = (key << 1) | ((cells[p] >> bit) & 1);
       }
+    }
+    keys[node] = {key, static_cast<node_id_t>(node)};
+  }
+  std::sort(keys.begin(), keys.end());
 
-      while (Q.size() > 0) {
-        // exhause all the neighbors
-        node_id_t candidate = Q.front();
-        Q.pop();
-        if (!visited_set.isVisited(candidate)) {
-          P.push_back(candidate);
-          visited_set.insert(candidate);
-
-          // get list of neighbors of candidate
-          std::vector<std::pair<node_id_t, int>> candidate_neighbors;
-          for (auto& edge : outdegree_table[candidate]) {
-            candidate_neighbors.push_back({edge, degrees[edge]});
-          }
-          // sort neighbors by degree (min degree first)
-          std::sort(candidate_neighbors.begin(), candidate_neighbors.end(),
-                    [](const std::pair<node_id_t, int>& a, const std::pair<node_id_t, int>& b) {
-                      return a.second < b.second;
-                    });
-          // add neighbors to queue
-          for (int j = 0; j < candidate_neighbors.size(); j++) {
-            Q.push(candidate_neighbors[j].first);
-          }
+  std::vector<node_id_t> Pinv(num_nodes, 0);
+  for (size_t n = 0; n < num_nodes; n++) {
+    Pinv[keys[n].second] = n;
+  }
+  return Pinv;
+}
+
+/**
+ * Vector-space ordering: nodes grouped by k-means cluster. Centroids are
+ * trained with Lloyd's algorithm on a random sample of the vectors, every
+ * node is assigned to its nearest centroid, and clusters are laid out in the
+ * Z-order of their centroids so that nearby clusters are also close in
+ * memory. Within a cluster, nodes keep their current order. `num_clusters` 0
+ * selects sqrt(num_nodes). Vectors are read as in `zOrder`.
+ */
+template <typename node_id_t, typename VectorReader>
+std::vector<node_id_t> kmeansOrder(size_t num_nodes, size_t dim, VectorReader read_vector, uint32_t num_threads,
+                                   size_t num_clusters = 0, int num_iterations = 10, uint64_t seed = 1234) {
+  if (num_clusters == 0) {
+    num_clusters = static_cast<size_t>(std::sqrt(static_cast<double>(num_nodes)));
+  }
+  num_clusters = std::max<size_t>(std::min(num_clusters, num_nodes), 1);
+
+  auto squared_distance = [dim](const float* x, const float* y) {
+    float distance = 0;
+    for (size_t d = 0; d < dim; d++) {
+      distance += (x[d] - y[d]) * (x[d] - y[d]);
+    }
+    return distance;
+  };
+
+  // Train on a sample of at most 64 vectors per cluster.
+  std::mt19937_64 generator(seed);
+  std::vector<node_id_t> sample(num_nodes);
+  std::iota(sample.begin(), sample.end(), 0);
+  size_t sample_size = std::min(num_nodes, 64 * num_clusters);
+  for (size_t i = 0; i < sample_size; i++) {
+    std::uniform_int_distribution<size_t> distribution(i, num_nodes - 1);
+    std::swap(sample[i], sample[distribution(generator)]);
+  }
+  sample.resize(sample_size);
+  std::vector<float> sample_vectors(sample_size * dim);
+  parallelRange(0, sample_size, num_threads, [&](uint64_t i) { read_vector(sample[i], sample_vectors.data() + i * dim); });
+
+  // The first num_clusters sampled vectors are distinct random seeds.
+  std::vector<float> centroids(sample_vectors.begin(), sample_vectors.begin() + num_clusters * dim);
+  auto nearest_centroid = [&](const float* vector) {
+    size_t nearest = 0;
+    float min_distance = std::numeric_limits<float>::max();
+    for (size_t c = 0; c < num_clusters; c++) {
+      float distance = squared_distance(vector, centroids.data() + c * dim);
+      if (distance < min_distance) {
+        min_distance = distance;
+        nearest = c;
+      }
+    }
+    return nearest;
+  };
+
+  std::vector<size_t> sample_assignment(sample_size);
+  for (int iteration = 0; iteration < num_iterations; iteration++) {
+    parallelRange(0, sample_size, num_threads,
+                  [&](uint64_t i) { sample_assignment[i] = nearest_centroid(sample_vectors.data() + i * dim); });
+    std::vector<double> sums(num_clusters * dim, 0.0);
+    std::vector<size_t> counts(num_clusters, 0);
+    for (size_t i = 0; i < sample_size; i++) {
+      counts[sample_assignment[i]]++;
+      for (size_t d = 0; d < dim; d++) {
+        sums[sample_assignment[i] * dim + d] += sample_vectors[i * dim + d];
+      }
+    }
+    // Empty clusters keep their centroid.
+    for (size_t c = 0; c < num_clusters; c++) {
+      for (size_t d = 0; counts[c] && d < dim; d++) {
+        centroids[c * dim + d] = sums[c * dim + d] / counts[c];
+      }
+    }
+  }
+
+  std::vector<size_t> assignment(num_nodes);
+  static constexpr size_t NODES_PER_BLOCK = 1024;
+  parallelRange(0, (num_nodes + NODES_PER_BLOCK - 1) / NODES_PER_BLOCK, num_threads, [&](uint64_t block) {
+    std::vector<float> vector(dim);
+    for (size_t node = block * NODES_PER_BLOCK; node < std::min((block + 1) * NODES_PER_BLOCK, num_nodes);
+         node++) {
+      read_vector(static_cast<node_id_t>(node), vector.data());
+      assignment[node] = nearest_centroid(vector.data());
+    }
+  });
+
+  std::vector<size_t> cluster_rank = zOrder<size_t>(
+      num_clusters, dim,
+      [&](size_t c, float* destination) {
+        std::copy(centroids.begin() + c * dim, centroids.begin() + (c + 1) * dim, destination);
+      },
+      /* num_threads = */ 1, /* num_projections = */ 8, seed);
+
+  // Counting sort of the nodes by cluster rank, stable within a cluster.
+  std::vector<size_t> offsets(num_clusters + 1, 0);
+  for (size_t node = 0; node < num_nodes; node++) {
+    offsets[cluster_rank[assignment[node]] + 1]++;
+  }
+  for (size_t c = 0; c < num_clusters; c++) {
+    offsets[c + 1] += offsets[c];
+  }
+  std::vector<node_id_t> Pinv(num_nodes, 0);
+  for (size_t node = 0; node < num_nodes; node++) {
+    Pinv[node] = offsets[cluster_rank[assignment[node]]]++;
+  }
+  return Pinv;
+}
+
+/**
+ * Reverse Cuthill-McKee ordering. Every connected component is traversed
+ * breadth-first from its lowest-degree node, children are visited in
+ * increasing degree, and the final order is reversed.
+ *
+ * The BFS is level-synchronous, so that each level is expanded in parallel.
+ * A node reachable from several parents of the frontier is claimed by the
+ * earliest one (an atomic min on the parent's position), which yields the
+ * same order as the sequential algorithm. Neighbor lists are sorted by degree
+ * once, up front, in a flat buffer.
+ */
+template <typename node_id_t>
+std::vector<node_id_t> rcmOrder(const CsrGraph<node_id_t>& graph, uint32_t num_threads = 1) {
+  // Below this frontier size, levels are expanded on the calling thread.
+  static constexpr size_t MIN_PARALLEL_FRONTIER = 1 << 12;
+  static constexpr size_t UNCLAIMED = std::numeric_limits<size_t>::max();
+
+  size_t cur_num_nodes = graph.numNodes();
+  const std::vector<uint64_t>& offsets = graph.offsets;
+  auto degree = [&](node_id_t node) { return offsets[node + 1] - offsets[node]; };
+  auto by_degree = [&](node_id_t a, node_id_t b) {
+    return degree(a) != degree(b) ? degree(a) < degree(b) : a < b;
+  };
+
+  std::vector<node_id_t> neighbors(graph.targets);
+  parallelRange(0, cur_num_nodes, num_threads, [&](uint64_t node) {
+    std::sort(neighbors.begin() + offsets[node], neighbors.begin() + offsets[node + 1], by_degree);
+  });
+
+  // Nodes by increasing degree (a counting sort, stable in node id).
+  size_t max_degree = 0;
+  for (size_t node = 0; node < cur_num_nodes; node++) {
+    max_degree = std::max(max_degree, degree(node));
+  }
+  std::vector<size_t> degree_offsets(max_degree + 2, 0);
+  for (size_t node = 0; node < cur_num_nodes; node++) {
+    degree_offsets[degree(node) + 1]++;
+  }
+  for (size_t d = 1; d < degree_offsets.size(); d++) {
+    degree_offsets[d] += degree_offsets[d - 1];
+  }
+  std::vector<node_id_t> start_nodes(cur_num_nodes);
+  for (size_t node = 0; node < cur_num_nodes; node++) {
+    start_nodes[degree_offsets[degree(node)]++] = node;
+  }
+
+  std::vector<uint8_t> visited(cur_num_nodes, 0);
+  std::vector<std::atomic<size_t>> claims(cur_num_nodes);
+  for (auto& claim : claims) {
+    claim.store(UNCLAIMED, std::memory_order_relaxed);
+  }
+
+  // Calls `function(child)` for every unvisited child of `parent`, in degree
+  // order, skipping repeated links.
+  auto forEachChild = [&](node_id_t parent, auto function) {
+    for (size_t j = offsets[parent]; j < offsets[parent + 1]; j++) {
+      node_id_t child = neighbors[j];
+      if (!visited[child] && (j == offsets[parent] || neighbors[j - 1] != child)) {
+        function(child);
+      }
+    }
+  };
+
+  std::vector<node_id_t> P;
+  P.reserve(cur_num_nodes);
+  std::vector<size_t> child_offsets;
+  for (node_id_t start : start_nodes) {
+    if (visited[start]) {
+      continue;
+    }
+    visited[start] = 1;
+    P.push_back(start);
+
+    size_t frontier_begin = P.size() - 1;
+    size_t frontier_end = P.size();
+    while (frontier_begin < frontier_end) {
+      if (num_threads <= 1 || frontier_end - frontier_begin < MIN_PARALLEL_FRONTIER) {
+        // Sequential expansion: the first parent to see a child takes it.
+        for (size_t i = frontier_begin; i < frontier_end; i++) {
+          forEachChild(P[i], [&](node_id_t child) {
+            visited[child] = 1;
+            P.push_back(child);
+          });
         }
+        frontier_begin = frontier_end;
+        frontier_end = P.size();
+        continue;
       }
+
+      // 1. Every unvisited child is claimed by its earliest parent.
+      parallelRange(frontier_begin, frontier_end, num_threads, [&](uint64_t i) {
+        forEachChild(P[i], [&](node_id_t child) {
+          size_t claim = claims[child].load(std::memory_order_relaxed);
+          while (i < claim && !claims[child].compare_exchange_weak(claim, i, std::memory_order_relaxed)) {
+          }
+        });
+      });
+
+      // 2. Parents append the children they claimed, in frontier order.
+      child_offsets.assign(frontier_end - frontier_begin + 1, 0);
+      parallelRange(frontier_begin, frontier_end, num_threads, [&](uint64_t i) {
+        forEachChild(P[i], [&](node_id_t child) {
+          child_offsets[i - frontier_begin + 1] += claims[child].load(std::memory_order_relaxed) == i;
+        });
+      });
+      for (size_t k = 1; k < child_offsets.size(); k++) {
+        child_offsets[k] += child_offsets[k - 1];
+      }
+      P.resize(frontier_end + child_offsets.back());
+      parallelRange(frontier_begin, frontier_end, num_threads, [&](uint64_t i) {
+        size_t position = frontier_end + child_offsets[i - frontier_begin];
+        forEachChild(P[i], [&](node_id_t child) {
+          if (claims[child].load(std::memory_order_relaxed) == i) {
+            P[position++] = child;
+          }
+        });
+      });
+
+      // 3. The children form the next frontier.
+      size_t next_end = P.size();
+      parallelRange(frontier_end, next_end, num_threads, [&](uint64_t i) { visited[P[i]] = 1; });
+      frontier_begin = frontier_end;
+      frontier_end = next_end;
     }
   }
 
   std::reverse(P.begin(), P.end());
   std::vector<node_id_t> Pinv(cur_num_nodes, 0);
-  for (int n = 0; n < cur_num_nodes; n++) {
+  for (size_t n = 0; n < cur_num_nodes; n++) {
     Pinv[P[n]] = n;
   }
   return Pinv;
@@ -11,9 +11,14 @@
 #pragma once
 
 #include <flatnav/util/Macros.h>
+#include <cstddef>
 
 namespace flatnav::util {
 
+// The signature of the distance kernels. Distances resolve their kernel into
+// such a pointer once, when they are constructed.
+using DistanceFunction = float (*)(const void* x, const void* y, const size_t& dimension);
+
 // clang-format off
 /**
  * @file SimdUtils.h
@@ -366,4 +371,21 @@ struct simd16float32 : public simd512bit {
 
 #endif // USE_AVX512
 
+#if defined(BUILD_AVX2_KERNELS)
+// Helpers of the AVX2 distance kernels, compiled for AVX2 like the kernels.
+
+TARGET_AVX2 inline float reduceAdd_Avx2(__m256 sum) {
+  __m128 sum128 = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+  sum128 = _mm_hadd_ps(sum128, sum128);
+  sum128 = _mm_hadd_ps(sum128, sum128);
+  return _mm_cvtss_f32(sum128);
+}
+
+// A mask for _mm256_maskload_ps of the first min(remaining, 8) lanes.
+TARGET_AVX2 inline __m256i residualMask_Avx2(size_t remaining) {
+  return _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(remaining < 8 ? remaining : 8)),
+                            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+#endif // BUILD_AVX2_KERNELS
+
 } // namespace flatnav::util
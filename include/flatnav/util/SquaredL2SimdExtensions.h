@@ -1,116 +1,277 @@
 #pragma once
 
+#include <flatnav/util/HalfPrecision.h>
 #include <flatnav/util/SimdUtils.h>
 
 namespace flatnav::util {
 
-#if defined(USE_AVX512)
-static float computeL2_Avx512(const void* x, const void* y, const size_t& dimension) {
-  float* pointer_x = static_cast<float*>(const_cast<void*>(x));
-  float* pointer_y = static_cast<float*>(const_cast<void*>(y));
+#if defined(BUILD_AVX512_KERNELS)
 
-  // Align to 16-floats boundary
-  const float* end_x = pointer_x + (dimension >> 4 << 4);
-  simd16float32 difference, v1, v2;
+// Squared L2 distance of float vectors of any dimension, 32 floats at a time
+// in two accumulators. The residual dimensions are read with a masked load.
+TARGET_AVX512 static float computeL2_Avx512(const void* x, const void* y, const size_t& dimension) {
+  const float* pointer_x = static_cast<const float*>(x);
+  const float* pointer_y = static_cast<const float*>(y);
 
-  simd16float32 sum(0.0f);
+  __m512 sum_0 = _mm512_setzero_ps();
+  __m512 sum_1 = _mm512_setzero_ps();
+  size_t i = 0;
+  for (; i + 32 <= dimension; i += 32) {
+    __m512 difference_0 = _mm512_sub_ps(_mm512_loadu_ps(pointer_x + i), _mm512_loadu_ps(pointer_y + i));
+    __m512 difference_1 =
+        _mm512_sub_ps(_mm512_loadu_ps(pointer_x + i + 16), _mm512_loadu_ps(pointer_y + i + 16));
+    sum_0 = _mm512_fmadd_ps(difference_0, difference_0, sum_0);
+    sum_1 = _mm512_fmadd_ps(difference_1, difference_1, sum_1);
+  }
+  for (; i < dimension; i += 16) {
+    __mmask16 mask = dimension - i >= 16 ? 0xFFFF : (__mmask16)((1u << (dimension - i)) - 1);
+    __m512 difference =
+        _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, pointer_x + i), _mm512_maskz_loadu_ps(mask, pointer_y + i));
+    sum_0 = _mm512_fmadd_ps(difference, difference, sum_0);
+  }
+  return _mm512_reduce_add_ps(_mm512_add_ps(sum_0, sum_1));
+}
 
-  while (pointer_x != end_x) {
-    v1.loadu(pointer_x);
-    v2.loadu(pointer_y);
-    difference = v1 - v2;
-    sum += difference * difference;
-    pointer_x += 16;
-    pointer_y += 16;
+// Squared L2 distances of 8-bit vectors are accumulated exactly in 32-bit
+// lanes: the differences of every 64 bytes are computed in 16 bits, and madd
+// squares them and adds adjacent ones into 32 bits. The tail
+// is read with a masked load, which fills the missing lanes of both vectors
+// with zeros.
+TARGET_AVX512 static float computeL2_Avx512_int8(const void* x, const void* y, const size_t& dimension) {
+  const int8_t* pointer_x = static_cast<const int8_t*>(x);
+  const int8_t* pointer_y = static_cast<const int8_t*>(y);
+
+  __m512i sum = _mm512_setzero_si512();
+  for (size_t i = 0; i < dimension; i += 64) {
+    __mmask64 mask = dimension - i >= 64 ? ~__mmask64(0) : (__mmask64(1) << (dimension - i)) - 1;
+    __m512i vx = _mm512_maskz_loadu_epi8(mask, pointer_x + i);
+    __m512i vy = _mm512_maskz_loadu_epi8(mask, pointer_y + i);
+
+    // Interleaving a vector with itself and shifting right sign-extends its
+    // bytes within each 128-bit lane, which is cheaper than a cross-lane
+    // conversion. The order of the 16-bit lanes does not matter for the sum.
+    __m512i difference_lo = _mm512_sub_epi16(_mm512_srai_epi16(_mm512_unpacklo_epi8(vx, vx), 8),
+                                             _mm512_srai_epi16(_mm512_unpacklo_epi8(vy, vy), 8));
+    __m512i difference_hi = _mm512_sub_epi16(_mm512_srai_epi16(_mm512_unpackhi_epi8(vx, vx), 8),
+                                             _mm512_srai_epi16(_mm512_unpackhi_epi8(vy, vy), 8));
+    sum = _mm512_add_epi32(sum, _mm512_madd_epi16(difference_lo, difference_lo));
+    sum = _mm512_add_epi32(sum, _mm512_madd_epi16(difference_hi, difference_hi));
   }
-  return sum.reduce_add();
+  return static_cast<float>(_mm512_reduce_add_epi32(sum));
 }
 
-/**
- * @todo Make this support dimensions that are not multiples of 64
- */
-static float computeL2_Avx512_Uint8(const void* x, const void* y, const size_t& dimension) {
+TARGET_AVX512 static float computeL2_Avx512_Uint8(const void* x, const void* y, const size_t& dimension) {
   const uint8_t* pointer_x = static_cast<const uint8_t*>(x);
   const uint8_t* pointer_y = static_cast<const uint8_t*>(y);
 
-  // Initialize sum to zero
   __m512i sum = _mm512_setzero_si512();
-
-  // Loop over the input arrays
   for (size_t i = 0; i < dimension; i += 64) {
-    // Load 64 bytes from each array
-    __m512i v1 = _mm512_loadu_si512(reinterpret_cast<const __m512i*>(pointer_x + i));
-    __m512i v2 = _mm512_loadu_si512(reinterpret_cast<const __m512i*>(pointer_y + i));
-
-    // Unpack to 16-bit integers to avoid overflow
-    __m512i v1_lo = _mm512_unpacklo_epi8(v1, _mm512_setzero_si512());
-    __m512i v1_hi = _mm512_unpackhi_epi8(v1, _mm512_setzero_si512());
-    __m512i v2_lo = _mm512_unpacklo_epi8(v2, _mm512_setzero_si512());
-    __m512i v2_hi = _mm512_unpackhi_epi8(v2, _mm512_setzero_si512());
-
-    // Compute differences
-    __m512i diff_lo = _mm512_sub_epi16(v1_lo, v2_lo);
-    __m512i diff_hi = _mm512_sub_epi16(v1_hi, v2_hi);
-
-    // Square the differences
-    __m512i diff_squared_lo = _mm512_madd_epi16(diff_lo, diff_lo);
-    __m512i diff_squared_hi = _mm512_madd_epi16(diff_hi, diff_hi);
-
-    // Accumulate the results
-    sum = _mm512_add_epi32(sum, diff_squared_lo);
-    sum = _mm512_add_epi32(sum, diff_squared_hi);
+    __mmask64 mask = dimension - i >= 64 ? ~__mmask64(0) : (__mmask64(1) << (dimension - i)) - 1;
+    __m512i vx = _mm512_maskz_loadu_epi8(mask, pointer_x + i);
+    __m512i vy = _mm512_maskz_loadu_epi8(mask, pointer_y + i);
+
+    // |x - y| fits in a byte, so only the difference is widened.
+    __m512i difference = _mm512_or_si512(_mm512_subs_epu8(vx, vy), _mm512_subs_epu8(vy, vx));
+    __m512i difference_lo = _mm512_unpacklo_epi8(difference, _mm512_setzero_si512());
+    __m512i difference_hi = _mm512_unpackhi_epi8(difference, _mm512_setzero_si512());
+    sum = _mm512_add_epi32(sum, _mm512_madd_epi16(difference_lo, difference_lo));
+    sum = _mm512_add_epi32(sum, _mm512_madd_epi16(difference_hi, difference_hi));
+  }
+  return static_cast<float>(_mm512_reduce_add_epi32(sum));
+}
+
+// Squared L2 distances on 16-bit float data (float16_t or bfloat16_t), from a
+// float32 query or from a vector of the same type. Values are converted to
+// float32 as they are loaded; the residual dimensions use a masked load.
+template <typename query_t, typename data_t>
+TARGET_AVX512 static float computeL2_Avx512_half(const void* query, const void* data,
+                                                 const size_t& dimension) {
+  const query_t* x = static_cast<const query_t*>(query);
+  const data_t* y = static_cast<const data_t*>(data);
+  __m512 sum_0 = _mm512_setzero_ps();
+  __m512 sum_1 = _mm512_setzero_ps();
+  size_t i = 0;
+  for (; i + 32 <= dimension; i += 32) {
+    __m512 difference_0 = _mm512_sub_ps(loadFloats_Avx512(x + i, 0xFFFF), loadFloats_Avx512(y + i, 0xFFFF));
+    __m512 difference_1 =
+        _mm512_sub_ps(loadFloats_Avx512(x + i + 16, 0xFFFF), loadFloats_Avx512(y + i + 16, 0xFFFF));
+    sum_0 = _mm512_fmadd_ps(difference_0, difference_0, sum_0);
+    sum_1 = _mm512_fmadd_ps(difference_1, difference_1, sum_1);
+  }
+  for (; i < dimension; i += 16) {
+    __mmask16 mask = dimension - i >= 16 ? 0xFFFF : (__mmask16)((1u << (dimension - i)) - 1);
+    __m512 difference = _mm512_sub_ps(loadFloats_Avx512(x + i, mask), loadFloats_Avx512(y + i, mask));
+    sum_0 = _mm512_fmadd_ps(difference, difference, sum_0);
   }
+  return _mm512_reduce_add_ps(_mm512_add_ps(sum_0, sum_1));
+}
 
-  // Sum all elements in the sum vector
-  __m256i sum256 = _mm512_extracti64x4_epi64(sum, 0);
-  sum256 = _mm256_add_epi32(sum256, _mm512_extracti64x4_epi64(sum, 1));
-  sum256 = _mm256_hadd_epi32(sum256, sum256);
-  sum256 = _mm256_hadd_epi32(sum256, sum256);
+#endif  // BUILD_AVX512_KERNELS
 
-  int32_t buffer[8];
-  _mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer), sum256);
+#if defined(BUILD_AVX512VNNI_KERNELS)
 
-  int32_t total_sum = buffer[0] + buffer[4];
+// Same as computeL2_Avx512_int8, with the squaring and accumulation of the
+// 16-bit differences fused into vpdpwssd. vpdpbusd does not apply because a
+// difference of two bytes does not fit in a signed byte.
+TARGET_AVX512VNNI static float computeL2_Avx512Vnni_int8(const void* x, const void* y,
+                                                         const size_t& dimension) {
+  const int8_t* pointer_x = static_cast<const int8_t*>(x);
+  const int8_t* pointer_y = static_cast<const int8_t*>(y);
 
-  return static_cast<float>(total_sum);
+  __m512i sum = _mm512_setzero_si512();
+  for (size_t i = 0; i < dimension; i += 64) {
+    __mmask64 mask = dimension - i >= 64 ? ~__mmask64(0) : (__mmask64(1) << (dimension - i)) - 1;
+    __m512i vx = _mm512_maskz_loadu_epi8(mask, pointer_x + i);
+    __m512i vy = _mm512_maskz_loadu_epi8(mask, pointer_y + i);
+
+    __m512i difference_lo = _mm512_sub_epi16(_mm512_srai_epi16(_mm512_unpacklo_epi8(vx, vx), 8),
+                                             _mm512_srai_epi16(_mm512_unpacklo_epi8(vy, vy), 8));
+    __m512i difference_hi = _mm512_sub_epi16(_mm512_srai_epi16(_mm512_unpackhi_epi8(vx, vx), 8),
+                                             _mm512_srai_epi16(_mm512_unpackhi_epi8(vy, vy), 8));
+    sum = _mm512_dpwssd_epi32(sum, difference_lo, difference_lo);
+    sum = _mm512_dpwssd_epi32(sum, difference_hi, difference_hi);
+  }
+  return static_cast<float>(_mm512_reduce_add_epi32(sum));
 }
 
-#endif  // USE_AVX512
+TARGET_AVX512VNNI static float computeL2_Avx512Vnni_uint8(const void* x, const void* y,
+                                                          const size_t& dimension) {
+  const uint8_t* pointer_x = static_cast<const uint8_t*>(x);
+  const uint8_t* pointer_y = static_cast<const uint8_t*>(y);
 
-#if defined(USE_AVX)
+  __m512i sum = _mm512_setzero_si512();
+  for (size_t i = 0; i < dimension; i += 64) {
+    __mmask64 mask = dimension - i >= 64 ? ~__mmask64(0) : (__mmask64(1) << (dimension - i)) - 1;
+    __m512i vx = _mm512_maskz_loadu_epi8(mask, pointer_x + i);
+    __m512i vy = _mm512_maskz_loadu_epi8(mask, pointer_y + i);
+
+    __m512i difference = _mm512_or_si512(_mm512_subs_epu8(vx, vy), _mm512_subs_epu8(vy, vx));
+    __m512i difference_lo = _mm512_unpacklo_epi8(difference, _mm512_setzero_si512());
+    __m512i difference_hi = _mm512_unpackhi_epi8(difference, _mm512_setzero_si512());
+    sum = _mm512_dpwssd_epi32(sum, difference_lo, difference_lo);
+    sum = _mm512_dpwssd_epi32(sum, difference_hi, difference_hi);
+  }
+  return static_cast<float>(_mm512_reduce_add_epi32(sum));
+}
 
-static float computeL2_Avx2(const void* x, const void* y, const size_t& dimension) {
-  float* pointer_x = static_cast<float*>(const_cast<void*>(x));
-  float* pointer_y = static_cast<float*>(const_cast<void*>(y));
+#endif  // BUILD_AVX512VNNI_KERNELS
 
-  const float* end_x = pointer_x + (dimension & ~7);
-  simd8float32 difference, v1, v2;
-  simd8float32 sum(0.0f);
+#if defined(BUILD_AVX2_KERNELS)
 
-  while (pointer_x != end_x) {
-    v1.loadu(pointer_x);
-    v2.loadu(pointer_y);
-    difference = v1 - v2;
-    sum += difference * difference;
+// Squared L2 distance of float vectors of any dimension, 16 floats at a time
+// in two accumulators. The residual dimensions are read with a masked load.
+TARGET_AVX2 static float computeL2_Avx2(const void* x, const void* y, const size_t& dimension) {
+  const float* pointer_x = static_cast<const float*>(x);
+  const float* pointer_y = static_cast<const float*>(y);
 
-    pointer_x += 8;
-    pointer_y += 8;
+  __m256 sum_0 = _mm256_setzero_ps();
+  __m256 sum_1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= dimension; i += 16) {
+    __m256 difference_0 = _mm256_sub_ps(_mm256_loadu_ps(pointer_x + i), _mm256_loadu_ps(pointer_y + i));
+    __m256 difference_1 =
+        _mm256_sub_ps(_mm256_loadu_ps(pointer_x + i + 8), _mm256_loadu_ps(pointer_y + i + 8));
+    sum_0 = _mm256_fmadd_ps(difference_0, difference_0, sum_0);
+    sum_1 = _mm256_fmadd_ps(difference_1, difference_1, sum_1);
+  }
+  for (; i < dimension; i += 8) {
+    __m256i mask = residualMask_Avx2(dimension - i);
+    __m256 difference =
+        _mm256_sub_ps(_mm256_maskload_ps(pointer_x + i, mask), _mm256_maskload_ps(pointer_y + i, mask));
+    sum_0 = _mm256_fmadd_ps(difference, difference, sum_0);
+  }
+  return reduceAdd_Avx2(_mm256_add_ps(sum_0, sum_1));
+}
 
-    v1.loadu(pointer_x);
-    v2.loadu(pointer_y);
-    difference = v1 - v2;
-    sum += difference * difference;
+// 8-bit squared L2 distances, 32 bytes at a time (see computeL2_Avx512_int8).
+// The residual dimensions are handled with scalar code.
+TARGET_AVX2 static float computeL2_Avx2_int8(const void* x, const void* y, const size_t& dimension) {
+  const int8_t* pointer_x = static_cast<const int8_t*>(x);
+  const int8_t* pointer_y = static_cast<const int8_t*>(y);
 
-    pointer_x += 8;
-    pointer_y += 8;
+  __m256i sum = _mm256_setzero_si256();
+  size_t aligned_dimension = dimension & ~size_t(31);
+  size_t i = 0;
+  for (; i < aligned_dimension; i += 32) {
+    __m256i vx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointer_x + i));
+    __m256i vy = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointer_y + i));
+
+    __m256i difference_lo = _mm256_sub_epi16(_mm256_srai_epi16(_mm256_unpacklo_epi8(vx, vx), 8),
+                                             _mm256_srai_epi16(_mm256_unpacklo_epi8(vy, vy), 8));
+    __m256i difference_hi = _mm256_sub_epi16(_mm256_srai_epi16(_mm256_unpackhi_epi8(vx, vx), 8),
+                                             _mm256_srai_epi16(_mm256_unpackhi_epi8(vy, vy), 8));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(difference_lo, difference_lo));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(difference_hi, difference_hi));
   }
 
-  float result[8];
-  sum.storeu(result);
-  return result[0] + result[1] + result[2] + result[3] + result[4] + result[5] + result[6] + result[7];
+  int32_t squared_distance = 0;
+  for (; i < dimension; i++) {
+    int32_t difference = pointer_x[i] - pointer_y[i];
+    squared_distance += difference * difference;
+  }
+  __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  sum128 = _mm_hadd_epi32(sum128, sum128);
+  sum128 = _mm_hadd_epi32(sum128, sum128);
+  return static_cast<float>(_mm_cvtsi128_si32(sum128) + squared_distance);
 }
 
-#endif  // USE_AVX
+TARGET_AVX2 static float computeL2_Avx2_uint8(const void* x, const void* y, const size_t& dimension) {
+  const uint8_t* pointer_x = static_cast<const uint8_t*>(x);
+  const uint8_t* pointer_y = static_cast<const uint8_t*>(y);
+
+  __m256i sum = _mm256_setzero_si256();
+  size_t aligned_dimension = dimension & ~size_t(31);
+  size_t i = 0;
+  for (; i < aligned_dimension; i += 32) {
+    __m256i vx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointer_x + i));
+    __m256i vy = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointer_y + i));
+
+    __m256i difference = _mm256_or_si256(_mm256_subs_epu8(vx, vy), _mm256_subs_epu8(vy, vx));
+    __m256i difference_lo = _mm256_unpacklo_epi8(difference, _mm256_setzero_si256());
+    __m256i difference_hi = _mm256_unpackhi_epi8(difference, _mm256_setzero_si256());
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(difference_lo, difference_lo));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(difference_hi, difference_hi));
+  }
+
+  int32_t squared_distance = 0;
+  for (; i < dimension; i++) {
+    int32_t difference = pointer_x[i] - pointer_y[i];
+    squared_distance += difference * difference;
+  }
+  __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  sum128 = _mm_hadd_epi32(sum128, sum128);
+  sum128 = _mm_hadd_epi32(sum128, sum128);
+  return static_cast<float>(_mm_cvtsi128_si32(sum128) + squared_distance);
+}
+
+// See computeL2_Avx512_half. The residual dimensions use scalar code.
+template <typename query_t, typename data_t>
+TARGET_AVX2 static float computeL2_Avx2_half(const void* query, const void* data, const size_t& dimension) {
+  const query_t* x = static_cast<const query_t*>(query);
+  const data_t* y = static_cast<const data_t*>(data);
+  __m256 sum_0 = _mm256_setzero_ps();
+  __m256 sum_1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= dimension; i += 16) {
+    __m256 difference_0 = _mm256_sub_ps(loadFloats_Avx2(x + i), loadFloats_Avx2(y + i));
+    __m256 difference_1 = _mm256_sub_ps(loadFloats_Avx2(x + i + 8), loadFloats_Avx2(y + i + 8));
+    sum_0 = _mm256_add_ps(sum_0, _mm256_mul_ps(difference_0, difference_0));
+    sum_1 = _mm256_add_ps(sum_1, _mm256_mul_ps(difference_1, difference_1));
+  }
+  if (i + 8 <= dimension) {
+    __m256 difference = _mm256_sub_ps(loadFloats_Avx2(x + i), loadFloats_Avx2(y + i));
+    sum_0 = _mm256_add_ps(sum_0, _mm256_mul_ps(difference, difference));
+    i += 8;
+  }
+  float squared_distance = reduceAdd_Avx2(_mm256_add_ps(sum_0, sum_1));
+  for (; i < dimension; i++) {
+    float difference = toFloat(x[i]) - toFloat(y[i]);
+    squared_distance += difference * difference;
+  }
+  return squared_distance;
+}
+
+#endif  // BUILD_AVX2_KERNELS
 
 #if defined(USE_SSE)
 
@@ -157,39 +318,62 @@ static float computeL2_Sse(const void* x, const void* y, const size_t& dimension
 
 #if defined(USE_SSE4_1)
 
-// This function computes the L2 distance between two int8 vectors using SSE2
-// instructions.
+// 8-bit squared L2 distances, 16 bytes at a time (see computeL2_Avx512_int8).
+// The residual dimensions are handled with scalar code.
 static float computeL2_Sse_int8(const void* x, const void* y, const size_t& dimension) {
-  int8_t* pointer_x = static_cast<int8_t*>(const_cast<void*>(x));
-  int8_t* pointer_y = static_cast<int8_t*>(const_cast<void*>(y));
+  const int8_t* pointer_x = static_cast<const int8_t*>(x);
+  const int8_t* pointer_y = static_cast<const int8_t*>(y);
 
   __m128i sum = _mm_setzero_si128();
-  size_t aligned_dimension = dimension & ~0xF;
+  size_t aligned_dimension = dimension & ~size_t(15);
   size_t i = 0;
-
   for (; i < aligned_dimension; i += 16) {
-    __m128i vx = _mm_loadu_si128(reinterpret_cast<__m128i*>(pointer_x + i));
-    __m128i vy = _mm_loadu_si128(reinterpret_cast<__m128i*>(pointer_y + i));
-    __m128i diff = _mm_sub_epi8(vx, vy);
+    __m128i vx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointer_x + i));
+    __m128i vy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointer_y + i));
+
+    __m128i difference_lo = _mm_sub_epi16(_mm_cvtepi8_epi16(vx), _mm_cvtepi8_epi16(vy));
+    __m128i difference_hi =
+        _mm_sub_epi16(_mm_cvtepi8_epi16(_mm_srli_si128(vx, 8)), _mm_cvtepi8_epi16(_mm_srli_si128(vy, 8)));
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(difference_lo, difference_lo));
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(difference_hi, difference_hi));
+  }
 
-    // Convert to 16-bit and square
-    __m128i diff_squared = _mm_madd_epi16(_mm_cvtepi8_epi16(diff), _mm_cvtepi8_epi16(diff));
+  int32_t squared_distance = 0;
+  for (; i < dimension; i++) {
+    int32_t difference = pointer_x[i] - pointer_y[i];
+    squared_distance += difference * difference;
+  }
+  sum = _mm_hadd_epi32(sum, sum);
+  sum = _mm_hadd_epi32(sum, sum);
+  return static_cast<float>(_mm_cvtsi128_si32(sum) + squared_distance);
+}
+
+static float computeL2_Sse_uint8(const void* x, const void* y, const size_t& dimension) {
+  const uint8_t* pointer_x = static_cast<const uint8_t*>(x);
+  const uint8_t* pointer_y = static_cast<const uint8_t*>(y);
 
-    // Accumulate in 32-bit integer
-    sum = _mm_add_epi32(sum, diff_squared);
+  __m128i sum = _mm_setzero_si128();
+  size_t aligned_dimension = dimension & ~size_t(15);
+  size_t i = 0;
+  for (; i < aligned_dimension; i += 16) {
+    __m128i vx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointer_x + i));
+    __m128i vy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointer_y + i));
+
+    __m128i difference = _mm_or_si128(_mm_subs_epu8(vx, vy), _mm_subs_epu8(vy, vx));
+    __m128i difference_lo = _mm_unpacklo_epi8(difference, _mm_setzero_si128());
+    __m128i difference_hi = _mm_unpackhi_epi8(difference, _mm_setzero_si128());
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(difference_lo, difference_lo));
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(difference_hi, difference_hi));
   }
 
-  // Handle the remaining elements
-  int32_t partial_sum = 0;
+  int32_t squared_distance = 0;
   for (; i < dimension; i++) {
-    int diff = pointer_x[i] - pointer_y[i];
-    partial_sum += diff * diff;
+    int32_t difference = pointer_x[i] - pointer_y[i];
+    squared_distance += difference * difference;
   }
-
-  // Reduce sum
-  int32_t buffer[4];
-  _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer), sum);
-  return static_cast<float>(buffer[0] + buffer[1] + buffer[2] + buffer[3] + partial_sum);
+  sum = _mm_hadd_epi32(sum, sum);
+  sum = _mm_hadd_epi32(sum, sum);
+  return static_cast<float>(_mm_cvtsi128_si32(sum) + squared_distance);
 }
 
 #endif  // USE_SSE4_1
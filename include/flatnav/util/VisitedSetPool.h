@@ -13,19 +13,22 @@
 
 namespace flatnav::util {
 
+// node_id_t: The integral node id type of the index. Only the argument types
+// depend on it, so the 32-bit instantiation is unchanged.
+template <typename node_id_t = uint32_t>
 class VisitedSet {
  private:
   uint8_t _mark;
   uint8_t* _table;
-  uint32_t _table_size;
+  size_t _table_size;
 
  public:
-  VisitedSet(const uint32_t size) : _mark(1), _table_size(size) {
+  VisitedSet(const size_t size) : _mark(1), _table_size(size) {
     // initialize values to 0
     _table = new uint8_t[_table_size]();
   }
 
-  inline void prefetch(const uint32_t num) const {
+  inline void prefetch(const node_id_t num) const {
 #ifdef USE_SSE
     _mm_prefetch(reinterpret_cast<const char*>(&_table[num]), _MM_HINT_T0);
 #endif
@@ -33,9 +36,9 @@ class VisitedSet {
 
   inline uint8_t getMark() const { return _mark; }
 
-  inline void insert(const uint32_t num) { _table[num] = _mark; }
+  inline void insert(const node_id_t num) { _table[num] = _mark; }
 
-  inline uint32_t size() const { return _table_size; }
+  inline size_t size() const { return _table_size; }
 
   inline void clear() {
     _mark++;
@@ -45,7 +48,7 @@ class VisitedSet {
     }
   }
 
-  inline bool isVisited(const uint32_t num) const { return _table[num] == _mark; }
+  inline bool isVisited(const node_id_t num) const { return _table[num] == _mark; }
 
   ~VisitedSet() { delete[] _table; }
 
@@ -118,8 +121,8 @@ class VisitedSet {
  *
  * Usage example:
  * @code
- * VisitedSetPool visited_pool(10, 1000);
- * VisitedSet* visited_set = visited_set_pool.pollAvailableSet();
+ * VisitedSetPool<> visited_pool(10, 1000);
+ * VisitedSet<>* visited_set = visited_set_pool.pollAvailableSet();
  * // Use the visited_set in a thread...
  * visited_set_pool.pushVisitedSet(visited_set);
  * @endcode
@@ -130,28 +133,29 @@ class VisitedSet {
  * corresponds to the number of nodes or elements that each visited_set is
  * expected to manage.
  */
+template <typename node_id_t = uint32_t>
 class VisitedSetPool {
-  std::vector<VisitedSet*> _visisted_set_pool;
+  std::vector<VisitedSet<node_id_t>*> _visisted_set_pool;
   std::mutex _pool_guard;
-  uint32_t _num_elements;
+  size_t _num_elements;
   uint32_t _max_pool_size;
 
  public:
-  VisitedSetPool(uint32_t initial_pool_size, uint32_t num_elements,
+  VisitedSetPool(uint32_t initial_pool_size, size_t num_elements,
                  uint32_t max_pool_size = std::thread::hardware_concurrency())
       : _visisted_set_pool(initial_pool_size), _num_elements(num_elements), _max_pool_size(max_pool_size) {
     if (initial_pool_size > max_pool_size) {
       throw std::invalid_argument("initial_pool_size must be less than or equal to max_pool_size");
     }
     for (uint32_t visited_set_id = 0; visited_set_id < _visisted_set_pool.size(); visited_set_id++) {
-      _visisted_set_pool[visited_set_id] = new VisitedSet(/* size = */ _num_elements);
+      _visisted_set_pool[visited_set_id] = new VisitedSet<node_id_t>(/* size = */ _num_elements);
     }
   }
 
   // TODO: Enforce the condition that we never allocate more than _max_pool_size
   // visited_sets. For now there is nothing stopping a user from allocating more
   // than _max_pool_size.
-  VisitedSet* pollAvailableSet() {
+  VisitedSet<node_id_t>* pollAvailableSet() {
     std::unique_lock<std::mutex> lock(_pool_guard);
 
     if (!_visisted_set_pool.empty()) {
@@ -159,13 +163,13 @@ class VisitedSetPool {
       _visisted_set_pool.pop_back();
       return visited_set;
     } else {
-      return new VisitedSet(/* size = */ _num_elements);
+      return new VisitedSet<node_id_t>(/* size = */ _num_elements);
     }
   }
 
   size_t poolSize() const { return _visisted_set_pool.size(); }
 
-  void pushVisitedSet(VisitedSet* visited_set) {
+  void pushVisitedSet(VisitedSet<node_id_t>* visited_set) {
     std::unique_lock<std::mutex> lock(_pool_guard);
 
     _visisted_set_pool.push_back(visited_set);
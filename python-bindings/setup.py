@@ -92,6 +92,7 @@ def construct_cmake_args() -> List[str]:
                 "sse2",
                 "sse3",
                 "avx",
+                "f16c",
                 "avx512f",
                 "avx512bw",
             ]
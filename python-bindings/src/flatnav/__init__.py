@@ -21,6 +21,13 @@ class _IndexModule:
         IndexIPUint8,
         IndexL2Int8,
         IndexIPInt8,
+        IndexL2Float16,
+        IndexIPFloat16,
+        IndexL2Bfloat16,
+        IndexIPBfloat16,
+        IndexCosineFloat,
+        IndexCosineFloat16,
+        IndexCosineBfloat16,
         create,
     )
 
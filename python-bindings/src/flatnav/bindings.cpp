@@ -1,4 +1,6 @@
 
+#include <flatnav/build/NNDescent.h>
+#include <flatnav/distances/CosineDistance.h>
 #include <flatnav/distances/DistanceInterface.h>
 #include <flatnav/distances/InnerProductDistance.h>
 #include <flatnav/distances/SquaredL2Distance.h>
@@ -26,6 +28,8 @@
 
 using flatnav::Index;
 using flatnav::EntryPolicy;
+using flatnav::PruningConfig;
+using flatnav::distances::CosineDistance;
 using flatnav::distances::DistanceInterface;
 using flatnav::distances::InnerProductDistance;
 using flatnav::distances::SquaredL2Distance;
@@ -37,7 +41,11 @@ namespace py = pybind11;
 template <typename Func, typename... Args>
 auto cast_and_call(DataType data_type, const py::array& array, Func&& function, Args&&... args) {
   switch (data_type) {
+    // float16 and bfloat16 indexes take float32 input, which the distance
+    // converts when vectors are stored.
     case DataType::float32:
+    case DataType::float16:
+    case DataType::bfloat16:
       return function(array.cast<py::array_t<float, py::array::c_style | py::array::forcecast>>(),
                       std::forward<Args>(args)...);
     case DataType::int8:
@@ -119,6 +127,64 @@ class PyIndex : public std::enable_shared_from_this<PyIndex<dist_t, label_t>> {
     }
   }
 
+  template <typename data_type>
+  void addBulkImpl(const py::array_t<data_type, py::array::c_style | py::array::forcecast>& data,
+                   int ef_construction, int num_initializations, int num_passes, py::object labels) {
+    auto num_vectors = data.shape(0);
+    auto data_dim = data.shape(1);
+    if (data.ndim() != 2 || data_dim != _dim) {
+      throw std::invalid_argument("Data has incorrect dimensions.");
+    }
+
+    std::vector<label_t> vec_labels(num_vectors);
+    if (labels.is_none()) {
+      std::iota(vec_labels.begin(), vec_labels.end(), 0);
+    } else {
+      try {
+        vec_labels = py::cast<std::vector<label_t>>(labels);
+      } catch (const py::cast_error& error) {
+        throw std::invalid_argument("Invalid labels provided.");
+      }
+      if (vec_labels.size() != num_vectors) {
+        throw std::invalid_argument("Incorrect number of labels.");
+      }
+    }
+
+    // Release python GIL while threads are running
+    py::gil_scoped_release gil;
+    this->_index->template addBulk<data_type>(
+        /* data = */ (void*)data.data(0), /* labels = */ vec_labels,
+        /* ef_construction = */ ef_construction,
+        /* num_initializations = */ num_initializations, /* num_passes = */ num_passes);
+  }
+
+  template <typename data_type>
+  void updateImpl(const py::array_t<data_type, py::array::c_style | py::array::forcecast>& data,
+                  const py::object& labels, int ef_construction, int num_initializations = 100) {
+    auto num_vectors = data.shape(0);
+    auto data_dim = data.shape(1);
+    if (data.ndim() != 2 || data_dim != _dim) {
+      throw std::invalid_argument("Data has incorrect dimensions.");
+    }
+
+    std::vector<label_t> vec_labels;
+    try {
+      vec_labels = py::cast<std::vector<label_t>>(labels);
+    } catch (const py::cast_error& error) {
+      throw std::invalid_argument("Invalid labels provided.");
+    }
+    if (vec_labels.size() != num_vectors) {
+      throw std::invalid_argument("Incorrect number of labels.");
+    }
+
+    // Release python GIL while threads are running
+    py::gil_scoped_release gil;
+    this->_index->template updateBatch<data_type>(
+        /* data = */ (void*)data.data(0), /* labels = */ vec_labels,
+        /* ef_construction = */ ef_construction,
+        /* num_initializations = */ num_initializations);
+  }
+
   template <typename data_type>
   DistancesLabelsPair searchSingleImpl(
       const py::array_t<data_type, py::array::c_style | py::array::forcecast>& query, int K, int ef_search,
@@ -239,7 +305,7 @@ class PyIndex : public std::enable_shared_from_this<PyIndex<dist_t, label_t>> {
 
   PyIndex(std::unique_ptr<DistanceInterface<dist_t>>&& distance, DataType data_type, int dataset_size,
           int max_edges_per_node, bool verbose = false, bool collect_stats = false, 
-          EntryPolicy entry_policy = EntryPolicy::Strided)
+          EntryPolicy entry_policy = EntryPolicy::Strided, PruningConfig pruning = PruningConfig())
       : _dim(distance->dimension()),
         _label_id(0),
         _verbose(verbose),
@@ -249,7 +315,8 @@ class PyIndex : public std::enable_shared_from_this<PyIndex<dist_t, label_t>> {
             /* max_edges_per_node = */ max_edges_per_node,
             /* collect_stats = */ collect_stats,
             /* data_type = */ data_type,
-            /* entry_policy = */ entry_policy)) {
+            /* entry_policy = */ entry_policy,
+            /* pruning = */ pruning)) {
 
     if (_verbose) {
       uint64_t total_index_memory = _index->getTotalIndexMemory();
@@ -281,22 +348,193 @@ class PyIndex : public std::enable_shared_from_this<PyIndex<dist_t, label_t>> {
   }
 
 
+  void importKnnGraph(const py::array_t<int32_t, py::array::c_style | py::array::forcecast>& neighbors,
+                      bool prune, bool add_reverse_edges) {
+    if (neighbors.ndim() != 2) {
+      throw std::invalid_argument("The kNN graph must be a 2D array of shape (num_nodes, k).");
+    }
+    py::gil_scoped_release gil;
+    _index->importKnnGraph(/* neighbors = */ neighbors.data(0), /* num_nodes = */ neighbors.shape(0),
+                           /* k = */ neighbors.shape(1), /* prune = */ prune,
+                           /* add_reverse_edges = */ add_reverse_edges);
+  }
+
+  void buildGraphLinksNNDescent(size_t k, float sample_rate, size_t max_iterations, float delta, bool prune,
+                                bool add_reverse_edges) {
+    flatnav::build::NNDescentParameters parameters;
+    parameters.k = k;
+    parameters.sample_rate = sample_rate;
+    parameters.max_iterations = max_iterations;
+    parameters.delta = delta;
+    parameters.prune = prune;
+    parameters.add_reverse_edges = add_reverse_edges;
+    py::gil_scoped_release gil;
+    flatnav::build::nnDescent(*_index, parameters);
+  }
+
+  void importKnnGraphFile(const std::string& npy_filename, bool prune, bool add_reverse_edges) {
+    py::gil_scoped_release gil;
+    _index->importKnnGraph(/* npy_filename = */ npy_filename, /* prune = */ prune,
+                           /* add_reverse_edges = */ add_reverse_edges);
+  }
+
   std::vector<std::vector<uint32_t>> getGraphOutdegreeTable() { return _index->getGraphOutdegreeTable(); }
 
+  std::pair<py::array_t<uint64_t>, py::array_t<uint32_t>> getGraphCsr() {
+    auto* graph = new flatnav::util::CsrGraph<uint32_t>();
+    {
+      py::gil_scoped_release gil;
+      *graph = _index->getGraphCsr();
+    }
+
+    // Both arrays view the buffers of the graph, which is freed once neither
+    // array is referenced anymore.
+    py::capsule free_graph_when_done(graph,
+                                     [](void* ptr) { delete (flatnav::util::CsrGraph<uint32_t>*)ptr; });
+    py::array_t<uint64_t> offsets({graph->offsets.size()}, {sizeof(uint64_t)}, graph->offsets.data(),
+                                  free_graph_when_done);
+    py::array_t<uint32_t> targets({graph->targets.size()}, {sizeof(uint32_t)}, graph->targets.data(),
+                                  free_graph_when_done);
+    return {offsets, targets};
+  }
+
+  py::dict getGraphStats(int num_initializations) {
+    flatnav::util::GraphStats stats;
+    {
+      py::gil_scoped_release gil;
+      stats = _index->graphStats(num_initializations);
+    }
+    py::dict result;
+    result["num_nodes"] = stats.num_nodes;
+    result["num_edges"] = stats.num_edges;
+    result["unused_link_fraction"] = stats.unused_link_fraction;
+    result["out_degree_histogram"] = py::array_t<size_t>(stats.out_degree_histogram.size(),
+                                                         stats.out_degree_histogram.data());
+    result["in_degree_histogram"] =
+        py::array_t<size_t>(stats.in_degree_histogram.size(), stats.in_degree_histogram.data());
+    result["num_strongly_connected_components"] = stats.num_strongly_connected_components;
+    result["largest_strongly_connected_component"] = stats.largest_strongly_connected_component;
+    result["num_entry_nodes"] = stats.num_entry_nodes;
+    result["num_reachable_nodes"] = stats.num_reachable_nodes;
+    result["in_degree_skewness"] = stats.in_degree_skewness;
+    result["top_percent_in_edge_fraction"] = stats.top_percent_in_edge_fraction;
+    return result;
+  }
+
+  size_t repairConnectivity(int ef_search, size_t min_in_degree, int num_initializations, size_t max_rounds) {
+    py::gil_scoped_release gil;
+    return _index->repairConnectivity(/* ef_search = */ ef_search, /* min_in_degree = */ min_in_degree,
+                                      /* num_initializations = */ num_initializations,
+                                      /* max_rounds = */ max_rounds);
+  }
+
   uint32_t getMaxEdgesPerNode() { return _index->maxEdgesPerNode(); }
 
+  std::vector<uint32_t> getPermutation() { return _index->permutation(); }
+
   void reorder(const std::vector<std::string>& strategies) {
     // validate the given strategies
     for (auto& strategy : strategies) {
       auto alg = strategy;
       std::transform(alg.begin(), alg.end(), alg.begin(), [](unsigned char c) { return std::tolower(c); });
-      if (alg != "gorder" && alg != "rcm") {
+      if (alg != "gorder" && alg != "pgorder" && alg != "rcm" && alg != "frequency" && alg != "zorder" &&
+          alg != "kmeans") {
         throw std::invalid_argument("`" + strategy + "` is not a supported graph re-ordering strategy.");
       }
     }
     _index->doGraphReordering(strategies);
   }
 
+  void enableLinkDistances() { _index->enableLinkDistances(); }
+
+  void dropLinkDistances() { _index->dropLinkDistances(); }
+
+  void enableLabelLookup() { _index->enableLabelLookup(); }
+
+  bool contains(label_t label) { return _index->contains(label); }
+
+  py::array getVector(label_t label) {
+    const void* vector = _index->getVector(label);
+    switch (_index->getDataType()) {
+      case DataType::float32:
+        return py::array_t<float>({(size_t)_dim}, static_cast<const float*>(vector));
+      case DataType::int8:
+        return py::array_t<int8_t>({(size_t)_dim}, static_cast<const int8_t*>(vector));
+      case DataType::uint8:
+        return py::array_t<uint8_t>({(size_t)_dim}, static_cast<const uint8_t*>(vector));
+      case DataType::float16: {
+        py::array_t<float> decoded(_dim);
+        flatnav::util::convertToFloat(static_cast<const flatnav::util::float16_t*>(vector), decoded.mutable_data(),
+                                      _dim);
+        return decoded;
+      }
+      case DataType::bfloat16: {
+        py::array_t<float> decoded(_dim);
+        flatnav::util::convertToFloat(static_cast<const flatnav::util::bfloat16_t*>(vector),
+                                      decoded.mutable_data(), _dim);
+        return decoded;
+      }
+      default:
+        throw std::invalid_argument("Unsupported data type.");
+    }
+  }
+
+  DistancesLabelsPair searchByLabel(const std::vector<label_t>& query_labels, int K, int ef_search) {
+    size_t num_queries = query_labels.size();
+    auto num_threads = _index->getNumThreads();
+    label_t* results = new label_t[num_queries * K];
+    float* distances = new float[num_queries * K];
+
+    auto search_one = [&](uint32_t row_index) {
+      std::vector<std::pair<float, label_t>> top_k = this->_index->searchByLabel(
+          /* label = */ query_labels[row_index], /* K = */ K, /* ef_search = */ ef_search);
+      if (top_k.size() != K) {
+        throw std::runtime_error(
+            "Search did not return the expected number "
+            "of results. Expected " +
+            std::to_string(K) + " but got " + std::to_string(top_k.size()) + ".");
+      }
+      for (uint32_t result_id = 0; result_id < K; result_id++) {
+        distances[(row_index * K) + result_id] = top_k[result_id].first;
+        results[(row_index * K) + result_id] = top_k[result_id].second;
+      }
+    };
+
+    try {
+      // Validate every label up front so that worker threads never throw.
+      for (const auto& label : query_labels) {
+        if (!_index->contains(label)) {
+          throw std::invalid_argument("Label `" + std::to_string(label) + "` is not in the index.");
+        }
+      }
+      py::gil_scoped_release gil;
+      if (num_threads == 1) {
+        for (size_t query_index = 0; query_index < num_queries; query_index++) {
+          search_one(query_index);
+        }
+      } else {
+        flatnav::executeInParallel(
+            /* start_index = */ 0, /* end_index = */ num_queries,
+            /* num_threads = */ num_threads, /* function = */ search_one);
+      }
+    } catch (...) {
+      delete[] results;
+      delete[] distances;
+      throw;
+    }
+
+    // Allows to transfer ownership to Python
+    py::capsule free_results_when_done(results, [](void* ptr) { delete[] (label_t*)ptr; });
+    py::capsule free_distances_when_done(distances, [](void* ptr) { delete[] (float*)ptr; });
+
+    py::array_t<label_t> labels = py::array_t<label_t>(
+        {num_queries, (size_t)K}, {K * sizeof(label_t), sizeof(label_t)}, results, free_results_when_done);
+    py::array_t<float> dists = py::array_t<float>(
+        {num_queries, (size_t)K}, {K * sizeof(float), sizeof(float)}, distances, free_distances_when_done);
+
+    return {dists, labels};
+  }
+
   void setNumThreads(uint32_t num_threads) { _index->setNumThreads(num_threads); }
 
   uint32_t getNumThreads() { return _index->getNumThreads(); }
@@ -337,6 +575,28 @@ class PyIndex : public std::enable_shared_from_this<PyIndex<dist_t, label_t>> {
         ef_construction, num_initializations, labels);
   }
 
+  void addBulk(const py::array& data, int ef_construction, int num_initializations, int num_passes,
+               py::object labels = py::none()) {
+    auto data_type = _index->getDataType();
+    cast_and_call(
+        data_type, data,
+        [this](auto&& casted_data, int ef, int num_init, int passes, py::object lbls) {
+          this->addBulkImpl(std::forward<decltype(casted_data)>(casted_data), ef, num_init, passes, lbls);
+        },
+        ef_construction, num_initializations, num_passes, labels);
+  }
+
+  void update(const py::array& data, const py::object& labels, int ef_construction,
+              int num_initializations) {
+    auto data_type = _index->getDataType();
+    cast_and_call(
+        data_type, data,
+        [this](auto&& casted_data, const py::object& lbls, int ef, int num_init) {
+          this->updateImpl(std::forward<decltype(casted_data)>(casted_data), lbls, ef, num_init);
+        },
+        labels, ef_construction, num_initializations);
+  }
+
   DistancesLabelsPair search(const py::array& queries, int K, int ef_search, int num_initializations) {
     auto data_type = _index->getDataType();
     return cast_and_call(
@@ -379,6 +639,18 @@ struct IndexSpecialization<SquaredL2Distance<DataType::int8>> {
   static constexpr char* name = "IndexL2Int8";
 };
 
+template <>
+struct IndexSpecialization<SquaredL2Distance<DataType::float16>> {
+  using type = PyIndex<SquaredL2Distance<DataType::float16>, int>;
+  static constexpr char* name = "IndexL2Float16";
+};
+
+template <>
+struct IndexSpecialization<SquaredL2Distance<DataType::bfloat16>> {
+  using type = PyIndex<SquaredL2Distance<DataType::bfloat16>, int>;
+  static constexpr char* name = "IndexL2Bfloat16";
+};
+
 template <>
 struct IndexSpecialization<InnerProductDistance<DataType::float32>> {
   using type = PyIndex<InnerProductDistance<DataType::float32>, int>;
@@ -397,29 +669,75 @@ struct IndexSpecialization<InnerProductDistance<DataType::int8>> {
   static constexpr char* name = "IndexIPInt8";
 };
 
-void validateDistanceType(const std::string& distance_type) {
+template <>
+struct IndexSpecialization<InnerProductDistance<DataType::float16>> {
+  using type = PyIndex<InnerProductDistance<DataType::float16>, int>;
+  static constexpr char* name = "IndexIPFloat16";
+};
+
+template <>
+struct IndexSpecialization<InnerProductDistance<DataType::bfloat16>> {
+  using type = PyIndex<InnerProductDistance<DataType::bfloat16>, int>;
+  static constexpr char* name = "IndexIPBfloat16";
+};
+
+template <>
+struct IndexSpecialization<CosineDistance<DataType::float32>> {
+  using type = PyIndex<CosineDistance<DataType::float32>, int>;
+  static constexpr char* name = "IndexCosineFloat";
+};
+
+template <>
+struct IndexSpecialization<CosineDistance<DataType::float16>> {
+  using type = PyIndex<CosineDistance<DataType::float16>, int>;
+  static constexpr char* name = "IndexCosineFloat16";
+};
+
+template <>
+struct IndexSpecialization<CosineDistance<DataType::bfloat16>> {
+  using type = PyIndex<CosineDistance<DataType::bfloat16>, int>;
+  static constexpr char* name = "IndexCosineBfloat16";
+};
+
+// Returns the distance type in lower case.
+std::string validateDistanceType(const std::string& distance_type) {
   auto dist_type = distance_type;
   std::transform(dist_type.begin(), dist_type.end(), dist_type.begin(),
                  [](unsigned char c) { return std::tolower(c); });
 
-  if (dist_type != "l2" && dist_type != "angular") {
+  if (dist_type != "l2" && dist_type != "angular" && dist_type != "ip") {
     throw std::invalid_argument("Invalid distance type: `" + dist_type +
                                 "` during index construction. Valid options "
-                                "include `l2` and `angular`.");
+                                "include `l2`, `angular` and `ip`.");
   }
+  return dist_type;
 }
 
 template <DataType data_type, typename... Args>
 py::object createIndex(const std::string& distance_type, int dim, Args&&... args) {
-  validateDistanceType(distance_type);
+  auto dist_type = validateDistanceType(distance_type);
 
-  if (distance_type == "l2") {
+  if (dist_type == "l2") {
     auto distance = SquaredL2Distance<data_type>::create(dim);
     auto index = std::make_shared<PyIndex<SquaredL2Distance<data_type>, int>>(std::move(distance), data_type,
                                                                               std::forward<Args>(args)...);
     return py::cast(index);
   }
 
+  // Cosine distances normalize vectors, which integer data cannot hold.
+  if (dist_type == "angular") {
+    if constexpr (data_type == DataType::float32 || flatnav::util::isHalfPrecision(data_type)) {
+      auto distance = CosineDistance<data_type>::create(dim);
+      auto index = std::make_shared<PyIndex<CosineDistance<data_type>, int>>(std::move(distance), data_type,
+                                                                             std::forward<Args>(args)...);
+      return py::cast(index);
+    } else {
+      throw std::invalid_argument("The `angular` distance needs float32, float16 or bfloat16 data. Use `ip` for "
+                                  "the inner product of " +
+                                  std::string(flatnav::util::name(data_type)) + " vectors.");
+    }
+  }
+
   auto distance = InnerProductDistance<data_type>::create(dim);
   auto index = std::make_shared<PyIndex<InnerProductDistance<data_type>, int>>(std::move(distance), data_type,
                                                                                std::forward<Args>(args)...);
@@ -441,6 +759,22 @@ void bindSpecialization(py::module_& index_submodule) {
           },
           py::arg("data"), py::arg("ef_construction"), py::arg("num_initializations") = 100,
           py::arg("labels") = py::none(), ADD_DOCSTRING)
+      .def(
+          "add_bulk",
+          [](IndexType& index, const py::array& data, int ef_construction, int num_initializations = 100,
+             int num_passes = 1, py::object labels = py::none()) {
+            index.addBulk(data, ef_construction, num_initializations, num_passes, labels);
+          },
+          py::arg("data"), py::arg("ef_construction"), py::arg("num_initializations") = 100,
+          py::arg("num_passes") = 1, py::arg("labels") = py::none(), ADD_BULK_DOCSTRING)
+      .def(
+          "update",
+          [](IndexType& index, const py::array& data, const py::object& labels, int ef_construction,
+             int num_initializations = 100) {
+            index.update(data, labels, ef_construction, num_initializations);
+          },
+          py::arg("data"), py::arg("labels"), py::arg("ef_construction"),
+          py::arg("num_initializations") = 100, UPDATE_DOCSTRING)
       .def(
           "allocate_nodes",
           [](IndexType& index, const py::array_t<float, py::array::c_style | py::array::forcecast>& data) {
@@ -462,17 +796,38 @@ void bindSpecialization(py::module_& index_submodule) {
           },
           py::arg("queries"), py::arg("K"), py::arg("ef_search"), py::arg("num_initializations") = 100,
           SEARCH_DOCSTRING)
+      .def("enable_link_distances", &IndexType::enableLinkDistances, ENABLE_LINK_DISTANCES_DOCSTRING)
+      .def("drop_link_distances", &IndexType::dropLinkDistances, DROP_LINK_DISTANCES_DOCSTRING)
+      .def("enable_label_lookup", &IndexType::enableLabelLookup, ENABLE_LABEL_LOOKUP_DOCSTRING)
+      .def("contains", &IndexType::contains, py::arg("label"), CONTAINS_DOCSTRING)
+      .def("get_vector", &IndexType::getVector, py::arg("label"), GET_VECTOR_DOCSTRING)
+      .def("search_by_label", &IndexType::searchByLabel, py::arg("labels"), py::arg("K"),
+           py::arg("ef_search"), SEARCH_BY_LABEL_DOCSTRING)
       .def("get_query_distance_computations", &IndexType::getQueryDistanceComputations,
            GET_QUERY_DISTANCE_COMPUTATIONS_DOCSTRING)
       .def("save", &IndexType::save, py::arg("filename"), SAVE_DOCSTRING)
       .def("build_graph_links", &IndexType::buildGraphLinks, py::arg("mtx_filename"),
            BUILD_GRAPH_LINKS_DOCSTRING)
+      .def("import_knn_graph", &IndexType::importKnnGraph, py::arg("neighbors"), py::arg("prune") = true,
+           py::arg("add_reverse_edges") = true, IMPORT_KNN_GRAPH_DOCSTRING)
+      .def("import_knn_graph", &IndexType::importKnnGraphFile, py::arg("npy_filename"), py::arg("prune") = true,
+           py::arg("add_reverse_edges") = true, IMPORT_KNN_GRAPH_DOCSTRING)
+      .def("build_graph_links_nn_descent", &IndexType::buildGraphLinksNNDescent, py::arg("k") = 0,
+           py::arg("sample_rate") = 0.5f, py::arg("max_iterations") = 10, py::arg("delta") = 0.001f,
+           py::arg("prune") = true, py::arg("add_reverse_edges") = true, BUILD_GRAPH_LINKS_NN_DESCENT_DOCSTRING)
       .def("get_graph_outdegree_table", &IndexType::getGraphOutdegreeTable,
            GET_GRAPH_OUTDEGREE_TABLE_DOCSTRING)
+      .def("get_graph_csr", &IndexType::getGraphCsr, GET_GRAPH_CSR_DOCSTRING)
+      .def("graph_stats", &IndexType::getGraphStats, py::arg("num_initializations") = 100,
+           GRAPH_STATS_DOCSTRING)
+      .def("repair_connectivity", &IndexType::repairConnectivity, py::arg("ef_search") = 100,
+           py::arg("min_in_degree") = 1, py::arg("num_initializations") = 100, py::arg("max_rounds") = 4,
+           REPAIR_CONNECTIVITY_DOCSTRING)
       .def("reorder", &IndexType::reorder, py::arg("strategies"), REORDER_DOCSTRING)
       .def("set_num_threads", &IndexType::setNumThreads, py::arg("num_threads"), SET_NUM_THREADS_DOCSTRING)
       .def_static("load_index", &IndexType::loadIndex, py::arg("filename"), LOAD_INDEX_DOCSTRING)
       .def_property_readonly("max_edges_per_node", &IndexType::getMaxEdgesPerNode)
+      .def_property_readonly("permutation", &IndexType::getPermutation, PERMUTATION_DOCSTRING)
       .def_property_readonly("num_threads", &IndexType::getNumThreads, NUM_THREADS_DOCSTRING);
 }
 
@@ -480,24 +835,43 @@ void defineIndexSubmodule(py::module_& index_submodule) {
   bindSpecialization<SquaredL2Distance<DataType::float32>, int>(index_submodule);
   bindSpecialization<SquaredL2Distance<DataType::int8>, int>(index_submodule);
   bindSpecialization<SquaredL2Distance<DataType::uint8>, int>(index_submodule);
+  bindSpecialization<SquaredL2Distance<DataType::float16>, int>(index_submodule);
+  bindSpecialization<SquaredL2Distance<DataType::bfloat16>, int>(index_submodule);
   bindSpecialization<InnerProductDistance<DataType::float32>, int>(index_submodule);
   bindSpecialization<InnerProductDistance<DataType::int8>, int>(index_submodule);
   bindSpecialization<InnerProductDistance<DataType::uint8>, int>(index_submodule);
+  bindSpecialization<InnerProductDistance<DataType::float16>, int>(index_submodule);
+  bindSpecialization<InnerProductDistance<DataType::bfloat16>, int>(index_submodule);
+  bindSpecialization<CosineDistance<DataType::float32>, int>(index_submodule);
+  bindSpecialization<CosineDistance<DataType::float16>, int>(index_submodule);
+  bindSpecialization<CosineDistance<DataType::bfloat16>, int>(index_submodule);
 
   index_submodule.def(
       "create",
       [](const std::string& distance_type, int dim, int dataset_size, int max_edges_per_node,
-         DataType index_data_type, EntryPolicy index_entry_policy, bool verbose = false, bool collect_stats = false) {
+         DataType index_data_type, EntryPolicy index_entry_policy, bool verbose = false, bool collect_stats = false,
+         float alpha = 1.0f, bool keep_pruned = false, size_t forward_degree = 0, size_t backward_degree = 0) {
+        PruningConfig pruning;
+        pruning.alpha = alpha;
+        pruning.keep_pruned = keep_pruned;
+        pruning.forward_degree = forward_degree;
+        pruning.backward_degree = backward_degree;
         switch (index_data_type) {
           case DataType::float32:
             return createIndex<DataType::float32>(distance_type, dim, dataset_size, max_edges_per_node,
-                                                  verbose, collect_stats, index_entry_policy);
+                                                  verbose, collect_stats, index_entry_policy, pruning);
           case DataType::int8:
             return createIndex<DataType::int8>(distance_type, dim, dataset_size, max_edges_per_node, verbose,
-                                               collect_stats, index_entry_policy);
+                                               collect_stats, index_entry_policy, pruning);
           case DataType::uint8:
             return createIndex<DataType::uint8>(distance_type, dim, dataset_size, max_edges_per_node, verbose,
-                                                collect_stats, index_entry_policy);
+                                                collect_stats, index_entry_policy, pruning);
+          case DataType::float16:
+            return createIndex<DataType::float16>(distance_type, dim, dataset_size, max_edges_per_node,
+                                                  verbose, collect_stats, index_entry_policy, pruning);
+          case DataType::bfloat16:
+            return createIndex<DataType::bfloat16>(distance_type, dim, dataset_size, max_edges_per_node,
+                                                   verbose, collect_stats, index_entry_policy, pruning);
           default:
             throw std::runtime_error("Unsupported data type");
         }
@@ -507,6 +881,10 @@ void defineIndexSubmodule(py::module_& index_submodule) {
       py::arg("index_entry_policy") = EntryPolicy::Strided,
       py::arg("verbose") = false,
       py::arg("collect_stats") = false, 
+      py::arg("alpha") = 1.0f,
+      py::arg("keep_pruned") = false,
+      py::arg("forward_degree") = 0,
+      py::arg("backward_degree") = 0,
       CONSTRUCTOR_DOCSTRING);
 }
 
@@ -517,6 +895,8 @@ void defineDatatypeEnums(py::module_& module) {
       .value(flatnav::util::name(DataType::float32), DataType::float32)
       .value(flatnav::util::name(DataType::int8), DataType::int8)
       .value(flatnav::util::name(DataType::uint8), DataType::uint8)
+      .value(flatnav::util::name(DataType::float16), DataType::float16)
+      .value(flatnav::util::name(DataType::bfloat16), DataType::bfloat16)
       .export_values();
 }
 
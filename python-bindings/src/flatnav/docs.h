@@ -17,6 +17,33 @@ Returns:
     None
 )pbdoc";
 
+static const char *ADD_BULK_DOCSTRING = R"pbdoc(
+Add vectors(data) to the index with a batch-parallel builder. Batches of vectors are searched 
+in parallel against a frozen snapshot of the graph, then linked in a lock-free commit phase. 
+This is usually several times faster than `add` with many threads, and produces a graph in the 
+same format. Additional passes re-link every node against the complete graph.
+Args:
+    data (np.ndarray): The data to add to the index.
+    ef_construction (int): The number of vertices to visit while inserting every vector in the graph.
+    num_initializations (int, optional): The number of initializations to perform. Defaults to 100.
+    num_passes (int, optional): The number of passes over the graph. Defaults to 1.
+    labels (Optional[np.ndarray], optional): The labels for the data. Defaults to None.
+Returns:
+    None
+)pbdoc";
+
+static const char *UPDATE_DOCSTRING = R"pbdoc(
+Replace the vectors stored under the given labels with new ones. Each updated node keeps its
+label and is re-linked into the graph, at roughly the cost of a single insertion.
+Args:
+    data (np.ndarray): The new vectors.
+    labels (np.ndarray): The labels of the vectors to update. Every label must already be in the index.
+    ef_construction (int): The number of vertices to visit while re-linking every vector in the graph.
+    num_initializations (int, optional): The number of initializations to perform. Defaults to 100.
+Returns:
+    None
+)pbdoc";
+
 static const char *ALLOCATE_NODES_DOCSTRING = R"pbdoc(
 Allocate nodes in the underlying graph structure for the given data. Unlike the add method, 
 this method does not construct the edge connectivity. It only allocates memory for each node 
@@ -57,12 +84,96 @@ Returns:
     Tuple[np.ndarray, np.ndarray]: The distances and label ID's of the closest neighbors.
 )pbdoc";
 
+static const char *ENABLE_LINK_DISTANCES_DOCSTRING = R"pbdoc(
+Cache the distance from every node to each of its links. When a node has no free link left, 
+construction then prunes its links without recomputing the distances to all of them. This 
+speeds up `add` and `update` at the cost of `max_edges_per_node` floats per node. Call it before 
+adding data. The cache is not saved with the index.
+Returns:
+    None
+)pbdoc";
+
+static const char *DROP_LINK_DISTANCES_DOCSTRING = R"pbdoc(
+Free the link distance cache, e.g. once the index is built and will only be searched.
+Returns:
+    None
+)pbdoc";
+
+static const char *ENABLE_LABEL_LOOKUP_DOCSTRING = R"pbdoc(
+Build a label -> node map so that `contains`, `get_vector`, `search_by_label` and `update` 
+resolve labels in constant time instead of scanning the whole index. The map is kept up to 
+date by `add` and `reorder`, but it is not saved with the index.
+Returns:
+    None
+)pbdoc";
+
+static const char *CONTAINS_DOCSTRING = R"pbdoc(
+Check whether a vector with the given label is in the index.
+Args:
+    label (int): The label to look up.
+Returns:
+    bool: True if the label is in the index.
+)pbdoc";
+
+static const char *GET_VECTOR_DOCSTRING = R"pbdoc(
+Return a copy of the vector stored under the given label.
+Args:
+    label (int): The label to look up.
+Returns:
+    np.ndarray: The stored vector, with the data type of the index. float16 and bfloat16 vectors
+        are returned as float32.
+)pbdoc";
+
+static const char *SEARCH_BY_LABEL_DOCSTRING = R"pbdoc(
+Return the top `K` closest data points to vectors that are already in the index ("more like this").
+The stored vectors are used as queries, so no query data is transferred, and each item is excluded
+from its own results.
+Args:
+    labels (List[int]): The labels of the items to search around.
+    K (int): The number of neighbors to return.
+    ef_search (int): The number of neighbors to visit while finding the closest neighbors for every item.
+Returns:
+    Tuple[np.ndarray, np.ndarray]: The distances and label ID's of the closest neighbors.
+)pbdoc";
+
 static const char *GET_GRAPH_OUTDEGREE_TABLE_DOCSTRING = R"pbdoc(
 Returns the outdegree table (adjacency list) representation of the underlying graph.
 Returns:
     List[List[int]]: The outdegree table.
 )pbdoc";
 
+static const char *GET_GRAPH_CSR_DOCSTRING = R"pbdoc(
+Returns the underlying graph in compressed sparse row (CSR) form. The neighbors of node i are
+targets[offsets[i]:offsets[i + 1]]. This is much cheaper than `get_graph_outdegree_table` for
+large graphs, and the arrays are not copied.
+Returns:
+    Tuple[np.ndarray, np.ndarray]: The offsets (uint64, num_nodes + 1 entries) and targets (uint32).
+)pbdoc";
+
+static const char *GRAPH_STATS_DOCSTRING = R"pbdoc(
+Computes diagnostics of the underlying graph in parallel: out- and in-degree histograms, the
+fraction of unused link slots, strongly connected components, the number of nodes reachable
+from the entry points of the search and hubness of the in-degree (k-occurrence) distribution.
+Args:
+    num_initializations (int): The number of entry points considered, as in `search`.
+Returns:
+    Dict[str, Any]: The statistics, keyed by name. The histograms are numpy arrays indexed by degree.
+)pbdoc";
+
+static const char *REPAIR_CONNECTIVITY_DOCSTRING = R"pbdoc(
+Adds links into the nodes that searches cannot reach from the entry points, or that have too few
+in-links, so that they can be returned again. Run it once the index is built. New in-links come
+from the closest nodes found by searching for each such node, and are added under the pruning
+heuristic. The graph is checked again after every round.
+Args:
+    ef_search (int): The search beam width used to find the new in-neighbors.
+    min_in_degree (int): Nodes with fewer in-links are repaired.
+    num_initializations (int): The number of entry points considered, as in `search`.
+    max_rounds (int): The maximum number of rounds of checks and repairs.
+Returns:
+    int: The number of repair edges that were added.
+)pbdoc";
+
 static const char *BUILD_GRAPH_LINKS_DOCSTRING = R"pbdoc(
 Construct the edge connectivity of the underlying graph. This method should be invoked after 
 allocating nodes using the `allocate_nodes` method.
@@ -73,17 +184,61 @@ Returns:
     None
 )pbdoc";
 
+static const char *IMPORT_KNN_GRAPH_DOCSTRING = R"pbdoc(
+Construct the edge connectivity of the underlying graph from a precomputed kNN graph, e.g. one 
+computed offline on a GPU. This method should be invoked after allocating nodes using the 
+`allocate_nodes` method. Row i lists the nearest neighbors of the i-th allocated vector, closest 
+first. Negative, out of range, self and duplicate entries are skipped.
+Args:
+    neighbors (np.ndarray | str): A (num_nodes, k) integer array, or the path of a .npy file holding one.
+    prune (bool, optional): Select the links of every node with the pruning heuristic instead of keeping 
+        the first entries of its row. Defaults to True.
+    add_reverse_edges (bool, optional): Also add every selected link in the reverse direction. Defaults to True.
+Returns:
+    None
+)pbdoc";
+
+static const char *BUILD_GRAPH_LINKS_NN_DESCENT_DOCSTRING = R"pbdoc(
+Construct the edge connectivity of the underlying graph from an approximate kNN graph computed 
+with NN-Descent, using the index's threads. This method should be invoked after allocating nodes 
+using the `allocate_nodes` method. For indexes built in one batch it is usually much faster than `add`.
+Args:
+    k (int, optional): The number of neighbors per node in the kNN graph. 0 uses max_edges_per_node. Defaults to 0.
+    sample_rate (float, optional): The fraction of new neighbors joined per iteration, in (0, 1]. Defaults to 0.5.
+    max_iterations (int, optional): The maximum number of NN-Descent iterations. Defaults to 10.
+    delta (float, optional): Stop once an iteration updates fewer than delta * num_nodes * k neighbors. 
+        Defaults to 0.001.
+    prune (bool, optional): Select the links of every node with the pruning heuristic. Defaults to True.
+    add_reverse_edges (bool, optional): Also add every selected link in the reverse direction. Defaults to True.
+Returns:
+    None
+)pbdoc";
+
 static const char *REORDER_DOCSTRING = R"pbdoc(
 Perform graph re-ordering based on the given sequence of re-ordering strategies.
-Supported re-ordering strategies include `gorder` and `rcm`.
+Supported re-ordering strategies include `gorder`, `pgorder`, `rcm`, `frequency`, `zorder` and `kmeans`. 
+`pgorder` runs Gorder concurrently on one BFS partition of the graph per thread, which is much faster 
+with many threads and keeps most of the locality gain. `frequency` packs the nodes visited most by past 
+searches and their neighbors at the front of the index, so it should follow a representative query 
+workload. `zorder` and `kmeans` only look at the vectors: they sort nodes by the Z-order key of a random 
+low-dimensional projection, or group them by k-means cluster. They are much cheaper than Gorder.
 Reference: 
   1. Graph Reordering for Cache-Efficient Near Neighbor Search: https://arxiv.org/pdf/2104.03221
+The applied permutation is saved with the index, so an index re-ordered before `save` is loaded 
+with its cache-friendly layout and needs no re-ordering.
 Args:
     strategies (List[str]): The sequence of re-ordering strategies.
 Returns:
     None
 )pbdoc";
 
+static const char *PERMUTATION_DOCSTRING = R"pbdoc(
+The composition of every re-ordering applied to the index, saved with it: the vector inserted as 
+the i-th node is now stored at node `permutation[i]`. Empty if the index was never re-ordered. 
+Returns:
+    List[int]: The permutation.
+)pbdoc";
+
 static const char *SET_NUM_THREADS_DOCSTRING = R"pbdoc(
 Set the number of threads to use for constructing the graph and/or performing KNN search.
 Args:
@@ -130,12 +285,23 @@ Returns:
 static const char *CONSTRUCTOR_DOCSTRING = R"pbdoc(
 Constructs a an in-memory index with the parameters.
 Args:
-    distance_type (str): The type of distance metric to use ('l2' for Euclidean, 'angular' for inner product).
+    distance_type (str): The type of distance metric to use: 'l2' for Euclidean, 'angular' for cosine or
+        'ip' for inner product. Angular indexes normalize vectors when they are added and queries when
+        they are searched, so the input does not need to be normalized. They need float32, float16 or
+        bfloat16 data.
     dim (int): The number of dimensions in the dataset.
     dataset_size (int): The number of vectors in the dataset.
     max_edges_per_node (int): The maximum number of edges per node in the graph.
     verbose (bool, optional): Enables verbose output. Defaults to False.
     collect_stats (bool, optional): Collects performance statistics. Defaults to False.
+    alpha (float, optional): Pruning slack of the neighbor selection heuristic. 1.0 is the HNSW heuristic,
+        larger values (e.g. 1.2, as in DiskANN) keep more long edges. Defaults to 1.0.
+    keep_pruned (bool, optional): Fill the link slots left after pruning with the closest pruned candidates.
+        Defaults to False.
+    forward_degree (int, optional): Number of links selected for a new node. 0 uses max_edges_per_node / 2.
+        Defaults to 0.
+    backward_degree (int, optional): Number of links kept when a full link list is pruned. 0 uses
+        max_edges_per_node. Defaults to 0.
 
 Returns:
     Union[IndexL2Float, IndexIPFloat]: The constructed index.
@@ -159,7 +325,8 @@ Source Code:
 
 Submodules:
     data_type:
-        Definitions of supported data types for the index (e.g., float32, int8).
+        Definitions of supported data types for the index (e.g., float32, int8). float16 and
+        bfloat16 indexes take float32 vectors and queries and store vectors in 16 bits.
     index:
         Methods and classes for constructing, querying, and managing indices.
 
@@ -71,7 +71,7 @@ def test_flatnav_ip_index_random_dataset():
     ground_truth = np.random.randint(low=0, high=50, size=(5_000, 100))
 
     index = create_index(
-        distance_type="angular",
+        distance_type="ip",
         dim=dataset_to_index.shape[1],
         dataset_size=len(dataset_to_index),
         max_edges_per_node=16,
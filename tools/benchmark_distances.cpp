@@ -0,0 +1,79 @@
+#include <flatnav/distances/IPDistanceDispatcher.h>
+#include <flatnav/distances/L2DistanceDispatcher.h>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using flatnav::distances::defaultInnerProduct;
+using flatnav::distances::defaultSquaredL2;
+using flatnav::distances::IPDistanceDispatcher;
+using flatnav::distances::L2DistanceDispatcher;
+
+// Microbenchmark of the distance kernels: every kernel computes the distance
+// from a query to each vector of a small random dataset that stays in cache,
+// and the mean time per distance is reported next to the scalar code.
+
+static const size_t NUM_VECTORS = 1000;
+
+template <typename T>
+std::vector<T> generateVectors(size_t num_vectors, size_t dimension) {
+  std::mt19937 generator(1234);
+  std::uniform_int_distribution<int> distribution(0, 255);
+  std::vector<T> vectors(num_vectors * dimension);
+  for (auto& value : vectors) {
+    value = static_cast<T>(distribution(generator) - (std::is_signed_v<T> ? 128 : 0));
+  }
+  return vectors;
+}
+
+template <typename T, typename Distance>
+double nanosecondsPerDistance(const std::vector<T>& vectors, size_t dimension, int num_repetitions,
+                              Distance distance) {
+  volatile float sink = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int repetition = 0; repetition < num_repetitions; repetition++) {
+    const T* query = vectors.data() + (repetition % NUM_VECTORS) * dimension;
+    for (size_t i = 0; i < NUM_VECTORS; i++) {
+      sink = sink + distance(query, vectors.data() + i * dimension, dimension);
+    }
+  }
+  auto stop = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::nano>(stop - start).count() / (num_repetitions * NUM_VECTORS);
+}
+
+template <typename T>
+void benchmark(const std::string& type_name, size_t dimension, int num_repetitions) {
+  auto vectors = generateVectors<T>(NUM_VECTORS, dimension);
+  auto report = [&](const std::string& metric, double scalar, double dispatched) {
+    std::cout << std::setw(6) << type_name << std::setw(5) << metric << std::setw(8) << dimension << std::fixed
+              << std::setprecision(2) << std::setw(12) << scalar << std::setw(12) << dispatched << std::setw(9)
+              << scalar / dispatched << "x" << std::endl;
+  };
+
+  auto time = [&](auto distance) { return nanosecondsPerDistance(vectors, dimension, num_repetitions, distance); };
+
+  // The kernels are resolved once, as distances do.
+  auto ip_kernel = IPDistanceDispatcher::resolve<T, T>(dimension);
+  auto l2_kernel = L2DistanceDispatcher::resolve<T, T>(dimension);
+  report("IP", time([](const T* x, const T* y, size_t d) { return defaultInnerProduct<T>(x, y, d); }),
+         time([&](const T* x, const T* y, size_t d) { return ip_kernel(x, y, d); }));
+  report("L2", time([](const T* x, const T* y, size_t d) { return defaultSquaredL2<T>(x, y, d); }),
+         time([&](const T* x, const T* y, size_t d) { return l2_kernel(x, y, d); }));
+}
+
+int main(int argc, char** argv) {
+  int num_repetitions = argc > 1 ? std::stoi(argv[1]) : 200;
+
+  std::cout << "  type  dist     dim   scalar ns   kernel ns  speedup" << std::endl;
+  for (size_t dimension : {96, 100, 128, 200, 768}) {
+    benchmark<float>("float", dimension, num_repetitions);
+    benchmark<int8_t>("int8", dimension, num_repetitions);
+    benchmark<uint8_t>("uint8", dimension, num_repetitions);
+  }
+  return 0;
+}
@@ -13,6 +13,7 @@
 #include <numeric>
 #include <optional>
 #include <random>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <thread>
@@ -29,7 +30,8 @@ using flatnav::util::DataType;
 
 template <typename dist_t>
 void buildIndex(float* data, std::unique_ptr<DistanceInterface<dist_t>> distance, int N, int M, int dim,
-                int ef_construction, int build_num_threads, const std::string& save_file) {
+                int ef_construction, int build_num_threads, const std::string& save_file,
+                const std::vector<std::string>& reordering_methods) {
 
   auto index = new Index<dist_t, int>(
       /* dist = */ std::move(distance), /* dataset_size = */ N,
@@ -49,6 +51,16 @@ void buildIndex(float* data, std::unique_ptr<DistanceInterface<dist_t>> distance
   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
   std::clog << "Build time: " << (float)duration.count() << " milliseconds" << std::endl;
 
+  // Reorder before saving, so that the index is loaded with a cache-friendly
+  // layout and the permutation is recorded in the file.
+  if (!reordering_methods.empty()) {
+    start = std::chrono::high_resolution_clock::now();
+    index->doGraphReordering(reordering_methods);
+    stop = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    std::clog << "Reordering time: " << (float)duration.count() << " milliseconds" << std::endl;
+  }
+
   std::clog << "Saving index to: " << save_file << std::endl;
   index->saveIndex(/* filename = */ save_file);
 
@@ -56,7 +68,8 @@ void buildIndex(float* data, std::unique_ptr<DistanceInterface<dist_t>> distance
 }
 
 void run(float* data, flatnav::distances::MetricType metric_type, int N, int M, int dim, int ef_construction,
-         int build_num_threads, const std::string& save_file, bool quantize = false) {
+         int build_num_threads, const std::string& save_file, const std::vector<std::string>& reordering_methods,
+         bool quantize = false) {
 
   if (quantize) {
     // Parameters M and nbits should be adjusted accordingly.
@@ -71,18 +84,19 @@ void run(float* data, flatnav::distances::MetricType metric_type, int N, int M,
     std::clog << "Quantization time: " << (float)duration.count() << " milliseconds" << std::endl;
 
     buildIndex<ProductQuantizer>(data, std::move(quantizer), N, M, dim, ef_construction, build_num_threads,
-                                 save_file);
+                                 save_file, reordering_methods);
 
   } else {
     if (metric_type == flatnav::distances::MetricType::L2) {
       auto distance = SquaredL2Distance<>::create(dim);
       buildIndex<SquaredL2Distance<DataType::float32>>(data, std::move(distance), N, M, dim, ef_construction,
-                                                       build_num_threads, save_file);
+                                                       build_num_threads, save_file, reordering_methods);
 
     } else if (metric_type == flatnav::distances::MetricType::IP) {
       auto distance = InnerProductDistance<>::create(dim);
       buildIndex<InnerProductDistance<DataType::float32>>(data, std::move(distance), N, M, dim,
-                                                          ef_construction, build_num_threads, save_file);
+                                                          ef_construction, build_num_threads, save_file,
+                                                          reordering_methods);
     }
   }
 }
@@ -92,7 +106,7 @@ int main(int argc, char** argv) {
   if (argc < 8) {
     std::clog << "Usage: " << std::endl;
     std::clog << "construct <quantize> <metric> <data> <M> <ef_construction> "
-                 "<build_num_threads> <outfile>"
+                 "<build_num_threads> <outfile> [<reorder>]"
               << std::endl;
     std::clog << "\t <quantize> int, 0 for no quantization, 1 for quantization" << std::endl;
     std::clog << "\t <metric> int, 0 for L2, 1 for inner product (angular)" << std::endl;
@@ -101,6 +115,9 @@ int main(int argc, char** argv) {
     std::clog << "\t <ef_construction>: int " << std::endl;
     std::clog << "\t <build_num_threads>: int " << std::endl;
     std::clog << "\t <outfile>: where to stash the index" << std::endl;
+    std::clog << "\t <reorder>: optional comma-separated reordering strategies applied before "
+                 "saving (gorder, pgorder, rcm)"
+              << std::endl;
 
     return -1;
   }
@@ -111,6 +128,15 @@ int main(int argc, char** argv) {
   int M = std::stoi(argv[4]);
   int ef_construction = std::stoi(argv[5]);
 
+  std::vector<std::string> reordering_methods;
+  if (argc > 8) {
+    std::stringstream ss(argv[8]);
+    std::string method;
+    while (std::getline(ss, method, ',')) {
+      reordering_methods.push_back(method);
+    }
+  }
+
   if ((datafile.shape.size() != 2)) {
     return -1;
   }
@@ -129,6 +155,7 @@ int main(int argc, char** argv) {
       /* ef_construction = */ ef_construction,
       /* build_num_threads = */ std::stoi(argv[6]),
       /* save_file = */ argv[7],
+      /* reordering_methods = */ reordering_methods,
       /* quantize = */ quantize);
 
   return 0;
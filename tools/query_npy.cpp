@@ -31,7 +31,9 @@ void run(float* queries, int* gtruth, const std::string& index_filename, const s
   std::cout << "[INFO] Index loaded" << std::endl;
   index->getIndexSummary();
 
-  if (reorder) {
+  if (reorder && index->isReordered()) {
+    std::clog << "[INFO] Index was reordered before it was saved, skipping reordering" << std::endl;
+  } else if (reorder) {
     std::clog << "[INFO] Gorder Reordering: " << std::endl;
     auto start_r = std::chrono::high_resolution_clock::now();
     index->reorderGOrder();